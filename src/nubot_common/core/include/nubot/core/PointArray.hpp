@@ -0,0 +1,236 @@
+#ifndef __NUBOT_CORE_POINTARRAY_HPP__
+#define __NUBOT_CORE_POINTARRAY_HPP__
+
+#include "DPoint.hpp"
+#include "PPoint.hpp"
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+/** Array-level operations on whole point sets, e.g. all obstacles seen by a robot.
+ *  Coordinates are kept in contiguous buffers (structure of arrays) and every operation
+ *  is one branch-free loop, so the compiler turns it into SIMD instructions
+ *  ('#pragma omp simd' with -fopenmp or -fopenmp-simd, otherwise auto-vectorization at -O3). */
+
+#if defined(_OPENMP) || defined(HAVE_OPENMP_SIMD)
+#define NUBOT_SIMD_LOOP _Pragma("omp simd")
+#else
+#define NUBOT_SIMD_LOOP
+#endif
+
+namespace nubot
+{
+
+//! atan2 from a minimax polynomial (Abramowitz & Stegun 4.4.49), |error| <= 2e-8 rad for double.
+//! branch free, so loops calling it are vectorized; returns (-pi,pi], 0 for (0,0)
+template<typename _Tp> inline _Tp fast_atan2(_Tp y, _Tp x)
+{
+	const _Tp ax = std::fabs(x);
+	const _Tp ay = std::fabs(y);
+	const _Tp mx = ax > ay ? ax : ay;
+	const _Tp mn = ax > ay ? ay : ax;
+	const _Tp z  = mx > _Tp(0) ? mn / mx : _Tp(0);
+	const _Tp z2 = z * z;
+	_Tp p = _Tp(0.0028662257);
+	p = p * z2 - _Tp(0.0161657367);
+	p = p * z2 + _Tp(0.0429096138);
+	p = p * z2 - _Tp(0.0752896400);
+	p = p * z2 + _Tp(0.1065626393);
+	p = p * z2 - _Tp(0.1420889944);
+	p = p * z2 + _Tp(0.1999355085);
+	p = p * z2 - _Tp(0.3333314528);
+	_Tp a = z + z * z2 * p;
+	a = ay > ax ? _Tp(SINGLEPI_CONSTANT/2) - a : a;
+	a = x < _Tp(0) ? _Tp(SINGLEPI_CONSTANT) - a : a;
+	return y < _Tp(0) ? -a : a;
+}
+
+template<typename _Tp> class PPointArray_;
+
+template<typename _Tp> class DPointArray_
+{
+public:
+	typedef _Tp value_type;
+	DPointArray_();
+	explicit DPointArray_(std::size_t n);
+	template<typename _Tp2> DPointArray_(const std::vector< DPoint_<_Tp2> > & pts);
+
+	std::size_t size() const;
+	void resize(std::size_t n);
+	void reserve(std::size_t n);
+	void clear();
+	void push_back(const DPoint_<_Tp> & pt);
+	DPoint_<_Tp> operator [] (std::size_t i) const;
+	void set(std::size_t i, const DPoint_<_Tp> & pt);
+
+	//! polar coordinates in the frame at origin with the polar axis along heading,
+	//! e.g. obstacles in the ego frame of a robot; angles in (-pi,pi]
+	template<typename _Tp2> void to_polar(const DPoint_<_Tp2> & origin, const Angle & heading, PPointArray_<_Tp> & out) const;
+	//! the same as DPoint_::rotate(_angle) applied to every point
+	void rotate(const Angle & _angle, DPointArray_<_Tp> & out) const;
+	//! distance of every point to pt; out[i] = DPoint_::distance(pt) of point i
+	template<typename _Tp2> void distance_to(const DPoint_<_Tp2> & pt, std::vector<_Tp> & out) const;
+
+	std::vector<_Tp> x_, y_;   //< the point coordinates
+};
+
+template<typename _Tp> class PPointArray_
+{
+public:
+	typedef _Tp value_type;
+	PPointArray_();
+	explicit PPointArray_(std::size_t n);
+
+	std::size_t size() const;
+	void resize(std::size_t n);
+	void reserve(std::size_t n);
+	void clear();
+	void push_back(const PPoint_<_Tp> & pt);
+	PPoint_<_Tp> operator [] (std::size_t i) const;
+
+	//! cartesian coordinates of points given in the polar frame at origin with the polar axis
+	//! along heading; the inverse of DPointArray_::to_polar
+	template<typename _Tp2> void to_world(const DPoint_<_Tp2> & origin, const Angle & heading, DPointArray_<_Tp> & out) const;
+
+	std::vector<_Tp> angle_;   //< angles (rad)
+	std::vector<_Tp> radius_;  //< radii
+};
+
+typedef DPointArray_<float>  DPointArray2f;
+typedef DPointArray_<double> DPointArray2d;
+typedef DPointArray2d DPointArray;
+typedef PPointArray_<float>  PPointArray2f;
+typedef PPointArray_<double> PPointArray2d;
+typedef PPointArray2d PPointArray;
+
+//////////////////////////////// Cartesian Point Array ////////////////////////////////
+template<typename _Tp> inline DPointArray_<_Tp>::DPointArray_() {}
+template<typename _Tp> inline DPointArray_<_Tp>::DPointArray_(std::size_t n) : x_(n), y_(n) {}
+template<typename _Tp> template<typename _Tp2> inline DPointArray_<_Tp>::DPointArray_(const std::vector< DPoint_<_Tp2> > & pts)
+	: x_(pts.size()), y_(pts.size())
+{
+	for(std::size_t i = 0; i < pts.size(); i++)
+	{
+		x_[i] = _Tp(pts[i].x_);
+		y_[i] = _Tp(pts[i].y_);
+	}
+}
+
+template<typename _Tp> inline std::size_t DPointArray_<_Tp>::size() const
+{ return x_.size(); }
+template<typename _Tp> inline void DPointArray_<_Tp>::resize(std::size_t n)
+{ x_.resize(n); y_.resize(n); }
+template<typename _Tp> inline void DPointArray_<_Tp>::reserve(std::size_t n)
+{ x_.reserve(n); y_.reserve(n); }
+template<typename _Tp> inline void DPointArray_<_Tp>::clear()
+{ x_.clear(); y_.clear(); }
+template<typename _Tp> inline void DPointArray_<_Tp>::push_back(const DPoint_<_Tp> & pt)
+{ x_.push_back(pt.x_); y_.push_back(pt.y_); }
+template<typename _Tp> inline DPoint_<_Tp> DPointArray_<_Tp>::operator [] (std::size_t i) const
+{ return DPoint_<_Tp>(x_[i], y_[i]); }
+template<typename _Tp> inline void DPointArray_<_Tp>::set(std::size_t i, const DPoint_<_Tp> & pt)
+{ x_[i] = pt.x_; y_[i] = pt.y_; }
+
+template<typename _Tp> template<typename _Tp2>
+inline void DPointArray_<_Tp>::to_polar(const DPoint_<_Tp2> & origin, const Angle & heading, PPointArray_<_Tp> & out) const
+{
+	const std::size_t n = size();
+	out.resize(n);
+	if(n == 0)
+		return;
+	const _Tp ox = _Tp(origin.x_), oy = _Tp(origin.y_);
+	const _Tp c = _Tp(cos(heading.radian_)), s = _Tp(sin(heading.radian_));
+	const _Tp * x = &x_[0];
+	const _Tp * y = &y_[0];
+	_Tp * angle  = &out.angle_[0];
+	_Tp * radius = &out.radius_[0];
+	NUBOT_SIMD_LOOP
+	for(std::size_t i = 0; i < n; i++)
+	{
+		const _Tp dx = x[i] - ox;
+		const _Tp dy = y[i] - oy;
+		radius[i] = std::sqrt(dx*dx + dy*dy);
+		angle[i]  = fast_atan2(c*dy - s*dx, c*dx + s*dy);
+	}
+}
+
+template<typename _Tp> inline void DPointArray_<_Tp>::rotate(const Angle & _angle, DPointArray_<_Tp> & out) const
+{
+	const std::size_t n = size();
+	out.resize(n);
+	if(n == 0)
+		return;
+	const _Tp c = _Tp(cos(_angle.radian_)), s = _Tp(sin(_angle.radian_));
+	const _Tp * x = &x_[0];
+	const _Tp * y = &y_[0];
+	_Tp * rx = &out.x_[0];
+	_Tp * ry = &out.y_[0];
+	NUBOT_SIMD_LOOP
+	for(std::size_t i = 0; i < n; i++)
+	{
+		const _Tp px = x[i], py = y[i];    // out may be *this
+		rx[i] =  px*c + py*s;
+		ry[i] = -px*s + py*c;
+	}
+}
+
+template<typename _Tp> template<typename _Tp2>
+inline void DPointArray_<_Tp>::distance_to(const DPoint_<_Tp2> & pt, std::vector<_Tp> & out) const
+{
+	const std::size_t n = size();
+	out.resize(n);
+	if(n == 0)
+		return;
+	const _Tp px = _Tp(pt.x_), py = _Tp(pt.y_);
+	const _Tp * x = &x_[0];
+	const _Tp * y = &y_[0];
+	_Tp * d = &out[0];
+	NUBOT_SIMD_LOOP
+	for(std::size_t i = 0; i < n; i++)
+		d[i] = std::sqrt((x[i]-px)*(x[i]-px) + (y[i]-py)*(y[i]-py));
+}
+
+//////////////////////////////// Polar Point Array ////////////////////////////////
+template<typename _Tp> inline PPointArray_<_Tp>::PPointArray_() {}
+template<typename _Tp> inline PPointArray_<_Tp>::PPointArray_(std::size_t n) : angle_(n), radius_(n) {}
+
+template<typename _Tp> inline std::size_t PPointArray_<_Tp>::size() const
+{ return radius_.size(); }
+template<typename _Tp> inline void PPointArray_<_Tp>::resize(std::size_t n)
+{ angle_.resize(n); radius_.resize(n); }
+template<typename _Tp> inline void PPointArray_<_Tp>::reserve(std::size_t n)
+{ angle_.reserve(n); radius_.reserve(n); }
+template<typename _Tp> inline void PPointArray_<_Tp>::clear()
+{ angle_.clear(); radius_.clear(); }
+template<typename _Tp> inline void PPointArray_<_Tp>::push_back(const PPoint_<_Tp> & pt)
+{ angle_.push_back(_Tp(pt.angle_.radian_)); radius_.push_back(pt.radius_); }
+template<typename _Tp> inline PPoint_<_Tp> PPointArray_<_Tp>::operator [] (std::size_t i) const
+{ return PPoint_<_Tp>(Angle(angle_[i]), radius_[i]); }
+
+template<typename _Tp> template<typename _Tp2>
+inline void PPointArray_<_Tp>::to_world(const DPoint_<_Tp2> & origin, const Angle & heading, DPointArray_<_Tp> & out) const
+{
+	const std::size_t n = size();
+	out.resize(n);
+	if(n == 0)
+		return;
+	const _Tp ox = _Tp(origin.x_), oy = _Tp(origin.y_);
+	const _Tp c = _Tp(cos(heading.radian_)), s = _Tp(sin(heading.radian_));
+	const _Tp * angle  = &angle_[0];
+	const _Tp * radius = &radius_[0];
+	_Tp * x = &out.x_[0];
+	_Tp * y = &out.y_[0];
+	NUBOT_SIMD_LOOP
+	for(std::size_t i = 0; i < n; i++)
+	{
+		// point in the polar frame, then rotated by heading and moved to origin
+		const _Tp lx = radius[i] * std::cos(angle[i]);
+		const _Tp ly = radius[i] * std::sin(angle[i]);
+		x[i] = ox + c*lx - s*ly;
+		y[i] = oy + s*lx + c*ly;
+	}
+}
+
+}
+
+#endif //! __NUBOT_CORE_POINTARRAY_HPP__
@@ -7,6 +7,7 @@
 #include "DPoint.hpp"
 #include "PPoint.hpp"
 #include "Line.hpp"
+#include "PointArray.hpp"
 
 #define  SIMULATION
 #define  NET_TYPE "eth0"
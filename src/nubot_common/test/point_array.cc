@@ -0,0 +1,197 @@
+/* Desc: the batch point set operations of nubot/core/PointArray.hpp give the same points as
+ *       the per-point operations of DPoint_ and PPoint_ they stand for, in float and double.
+ * Usage: catkin_make run_tests_nubot_common
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <nubot/core/PointArray.hpp>
+
+using namespace nubot;
+
+static const unsigned int   POINTS = 1037;             // odd, so the remainder after the SIMD lanes runs too
+static const unsigned int   FRAMES = 200;
+
+/// \brief Largest differences allowed per coordinate type; lengths are up to 20 (m)
+template<typename _Tp> struct tolerance;
+template<> struct tolerance<double>
+{
+    static double angle()  { return 2e-8; }             // rad, as documented for fast_atan2()
+    static double length() { return 1e-6; }
+};
+template<> struct tolerance<float>
+{
+    static double angle()  { return 2e-6; }
+    static double length() { return 2e-5; }
+};
+
+/// \brief Distance of two angles on the circle, so that PI and -PI are the same angle
+static double angle_distance(double a, double b)
+{
+    return std::fabs(std::remainder(a - b, 2*SINGLEPI_CONSTANT));
+}
+
+template<typename _Tp> class PointArrayTest : public ::testing::Test
+{
+  protected:
+    PointArrayTest() : rng_(1), coordinate_(-10.0, 10.0), heading_(-SINGLEPI_CONSTANT, SINGLEPI_CONSTANT) {}
+
+    virtual void SetUp()
+    {
+        for(unsigned int i=0; i<POINTS; i++)
+            points_.push_back(DPoint_<_Tp>(_Tp(coordinate_(rng_)), _Tp(coordinate_(rng_))));
+        points_[5] = DPoint_<_Tp>(_Tp(0), _Tp(0));      // on the origin of the identity frame
+        points_[6] = DPoint_<_Tp>(_Tp(-1), _Tp(0));     // on the seam of the identity frame
+        array_ = DPointArray_<_Tp>(points_);
+    }
+
+    DPoint_<double> origin(void) { return DPoint_<double>(coordinate_(rng_), coordinate_(rng_)); }
+    Angle heading(void) { return Angle(heading_(rng_)); }
+
+    std::mt19937_64                         rng_;
+    std::uniform_real_distribution<double>  coordinate_;
+    std::uniform_real_distribution<double>  heading_;
+    std::vector< DPoint_<_Tp> >             points_;
+    DPointArray_<_Tp>                       array_;
+};
+
+typedef ::testing::Types<float, double> CoordinateTypes;
+TYPED_TEST_CASE(PointArrayTest, CoordinateTypes);
+
+TYPED_TEST(PointArrayTest, Elements)
+{
+    ASSERT_EQ(this->points_.size(), this->array_.size());
+    for(unsigned int i=0; i<POINTS; i++)
+    {
+        EXPECT_EQ(this->points_[i], this->array_[i]) << "point " << i;
+    }
+
+    DPointArray_<TypeParam> pushed;
+    for(unsigned int i=0; i<POINTS; i++)
+        pushed.push_back(this->points_[i]);
+    EXPECT_EQ(this->array_.x_, pushed.x_);
+    EXPECT_EQ(this->array_.y_, pushed.y_);
+}
+
+TYPED_TEST(PointArrayTest, ToPolarMatchesPPoint)
+{
+    PPointArray_<TypeParam> polar;
+    for(unsigned int k=0; k<FRAMES; k++)
+    {
+        const DPoint_<double> origin = k == 0 ? DPoint_<double>(0.0, 0.0) : this->origin();
+        const Angle heading = k == 0 ? Angle(0.0) : this->heading();
+        this->array_.to_polar(origin, heading, polar);
+        ASSERT_EQ(this->array_.size(), polar.size());
+        for(unsigned int i=0; i<POINTS; i++)
+        {
+            // the point in the frame, by DPoint_ and PPoint_
+            const DPoint_<double> relative = DPoint_<double>(this->points_[i]) - origin;
+            const PPoint_<double> expected(relative.rotate(heading));
+            EXPECT_NEAR(expected.radius_, polar.radius_[i], tolerance<TypeParam>::length()) << "point " << i;
+            if(expected.radius_ > tolerance<TypeParam>::length())
+            {
+                // rounding the point and the origin to the coordinate type turns near points the most
+                const double allowed = tolerance<TypeParam>::angle() + tolerance<TypeParam>::length() / expected.radius_;
+                EXPECT_LE(angle_distance(expected.angle_.radian_, polar.angle_[i]), allowed) << "point " << i;
+            }
+            EXPECT_GT(polar.angle_[i], -SINGLEPI_CONSTANT - tolerance<TypeParam>::angle()) << "point " << i;
+            EXPECT_LE(polar.angle_[i], SINGLEPI_CONSTANT + tolerance<TypeParam>::angle()) << "point " << i;
+        }
+        if(k == 0)                                      // a point on the origin has no direction
+        {
+            EXPECT_EQ(TypeParam(0), polar.radius_[5]);
+            EXPECT_EQ(TypeParam(0), polar.angle_[5]);
+        }
+    }
+}
+
+TYPED_TEST(PointArrayTest, ToWorldInvertsToPolar)
+{
+    PPointArray_<TypeParam> polar;
+    DPointArray_<TypeParam> world;
+    for(unsigned int k=0; k<FRAMES; k++)
+    {
+        const DPoint_<double> origin = this->origin();
+        const Angle heading = this->heading();
+        this->array_.to_polar(origin, heading, polar);
+        polar.to_world(origin, heading, world);
+        ASSERT_EQ(this->array_.size(), world.size());
+        for(unsigned int i=0; i<POINTS; i++)
+        {
+            // the angle error of fast_atan2() moves a point by up to its range times that error
+            const double allowed = tolerance<TypeParam>::length() + polar.radius_[i] * tolerance<TypeParam>::angle();
+            EXPECT_NEAR(this->points_[i].x_, world.x_[i], allowed) << "point " << i;
+            EXPECT_NEAR(this->points_[i].y_, world.y_[i], allowed) << "point " << i;
+        }
+    }
+}
+
+TYPED_TEST(PointArrayTest, RotateMatchesDPoint)
+{
+    DPointArray_<TypeParam> rotated;
+    for(unsigned int k=0; k<FRAMES; k++)
+    {
+        const Angle angle = this->heading();
+        this->array_.rotate(angle, rotated);
+        ASSERT_EQ(this->array_.size(), rotated.size());
+        for(unsigned int i=0; i<POINTS; i++)
+        {
+            const DPoint_<TypeParam> expected = this->points_[i].rotate(angle);
+            EXPECT_NEAR(expected.x_, rotated.x_[i], tolerance<TypeParam>::length()) << "point " << i;
+            EXPECT_NEAR(expected.y_, rotated.y_[i], tolerance<TypeParam>::length()) << "point " << i;
+        }
+    }
+
+    // in place, as the header allows
+    const Angle angle(0.7);
+    this->array_.rotate(angle, this->array_);
+    for(unsigned int i=0; i<POINTS; i++)
+    {
+        const DPoint_<TypeParam> expected = this->points_[i].rotate(angle);
+        EXPECT_NEAR(expected.x_, this->array_.x_[i], tolerance<TypeParam>::length()) << "point " << i;
+        EXPECT_NEAR(expected.y_, this->array_.y_[i], tolerance<TypeParam>::length()) << "point " << i;
+    }
+}
+
+TYPED_TEST(PointArrayTest, DistanceToMatchesDPoint)
+{
+    std::vector<TypeParam> distance;
+    for(unsigned int k=0; k<FRAMES; k++)
+    {
+        const DPoint_<double> pt = this->origin();
+        this->array_.distance_to(pt, distance);
+        ASSERT_EQ(this->array_.size(), distance.size());
+        for(unsigned int i=0; i<POINTS; i++)
+        {
+            EXPECT_NEAR(this->points_[i].distance(DPoint_<TypeParam>(pt)), distance[i], tolerance<TypeParam>::length())
+                << "point " << i;
+        }
+    }
+    this->array_.distance_to(this->points_[3], distance);
+    EXPECT_EQ(TypeParam(0), distance[3]);
+}
+
+TYPED_TEST(PointArrayTest, Empty)
+{
+    DPointArray_<TypeParam> empty, rotated(3);
+    PPointArray_<TypeParam> polar(3);
+    DPointArray_<TypeParam> world(3);
+    std::vector<TypeParam> distance(3);
+    empty.to_polar(DPoint_<double>(1.0, 2.0), Angle(0.5), polar);
+    empty.rotate(Angle(0.5), rotated);
+    empty.distance_to(DPoint_<double>(1.0, 2.0), distance);
+    polar.to_world(DPoint_<double>(1.0, 2.0), Angle(0.5), world);
+    EXPECT_EQ(0u, polar.size());
+    EXPECT_EQ(0u, rotated.size());
+    EXPECT_EQ(0u, distance.size());
+    EXPECT_EQ(0u, world.size());
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
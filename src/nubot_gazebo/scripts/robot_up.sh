@@ -7,36 +7,62 @@ declare -i j
 football_name=$(rosparam get /football/name)
 magenta_prefix=$(rosparam get /magenta/prefix)
 cyan_prefix=$(rosparam get /cyan/prefix)
+field_length=$(rosparam get /field/length)
+
+### Several fields in one world: models of field k > 0 are named field<k>_<name>, and field k
+### is shifted by k * spacing along y; see field_layout.hh
+declare -i field_num=$(rosparam get /fields/num 2>/dev/null || echo 1)
+field_spacing=$(rosparam get /fields/spacing 2>/dev/null || echo 20)
 		                               
 cyan_x=(0 -2.78 -1.5 -1.5 -5 -5 )  # the first one is for goal-keeper
 cyan_y=(0 0 1 -1 2 -2 )       # the first one is for goal-keeper 
 magenta_x=(0 2.78 1.5 1.5 5 5)      # the first one is not useful now
 magenta_y=(0 0 1 -1 2 -2 )     # the first one is not useful now-keeper
 
-### spawn the football
-rosrun gazebo_ros spawn_model -file $(rospack find nubot_description)/models/football/model.sdf -sdf \
-                              -model ${football_name} \
-                              -x 0.0 -y 0.0 -z 0.0 \
-                               /
-sleep 1
-
-### spawn cyan robots
-for ((i=1; i<=cyan_num; ++i))
+for ((k=0; k<field_num; ++k))
 do
-    rosrun gazebo_ros spawn_model -file $(rospack find nubot_description)/models/${cyan_prefix}${i}/model.sdf -sdf \
-                                  -model ${cyan_prefix}${i} \
-                                  -x ${cyan_x[$i]} -y ${cyan_y[$i]} -z 0.0 &
-    sleep 0.5
-done 
-
-### spawn magenta robots
-for ((i=1; i<=magenta_num; ++i))
-do
-    rosrun gazebo_ros spawn_model -file $(rospack find nubot_description)/models/${magenta_prefix}${i}/model.sdf -sdf \
-                                  -model ${magenta_prefix}${i} \
-                                  -x ${magenta_x[$i]} -y ${magenta_y[$i]} -z 0.0 &
-    sleep 0.5
-done 
+    if ((k > 0)); then
+        field_prefix=field${k}_
+    else
+        field_prefix=
+    fi
+    field_y=$(echo "${k} * ${field_spacing}" | bc)
+
+    ### the first field and its goals are part of the world file
+    if ((k > 0)); then
+        rosrun gazebo_ros spawn_model -database RoboCup15_MSL_Field -sdf -model ${field_prefix}field \
+                                      -x 0.0 -y ${field_y} -z 0.0
+        rosrun gazebo_ros spawn_model -database RoboCup15_MSL_Goal -sdf -model ${field_prefix}left_goal \
+                                      -x $(echo "-${field_length} / 2" | bc -l) -y ${field_y} -z 0.01 -Y -3.14
+        rosrun gazebo_ros spawn_model -database RoboCup15_MSL_Goal -sdf -model ${field_prefix}right_goal \
+                                      -x $(echo "${field_length} / 2" | bc -l) -y ${field_y} -z 0.01
+    fi
+
+    ### spawn the football
+    rosrun gazebo_ros spawn_model -file $(rospack find nubot_description)/models/football/model.sdf -sdf \
+                                  -model ${field_prefix}${football_name} \
+                                  -x 0.0 -y ${field_y} -z 0.0 \
+                                   /
+    sleep 1
+
+    ### spawn cyan robots
+    for ((i=1; i<=cyan_num; ++i))
+    do
+        rosrun gazebo_ros spawn_model -file $(rospack find nubot_description)/models/${cyan_prefix}${i}/model.sdf -sdf \
+                                      -model ${field_prefix}${cyan_prefix}${i} \
+                                      -x ${cyan_x[$i]} -y $(echo "${cyan_y[$i]} + ${field_y}" | bc) -z 0.0 &
+        sleep 0.5
+    done
+
+    ### spawn magenta robots
+    for ((i=1; i<=magenta_num; ++i))
+    do
+        rosrun gazebo_ros spawn_model -file $(rospack find nubot_description)/models/${magenta_prefix}${i}/model.sdf -sdf \
+                                      -model ${field_prefix}${magenta_prefix}${i} \
+                                      -x ${magenta_x[$i]} -y $(echo "${magenta_y[$i]} + ${field_y}" | bc) -z 0.0 &
+        sleep 0.5
+    done
+done
 
 
 ### use joystick
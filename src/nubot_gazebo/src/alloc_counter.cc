@@ -0,0 +1,64 @@
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new/delete to count heap allocations per thread.
+// Build as a shared library and LD_PRELOAD it into gzserver; see alloc_counter.hh.
+
+static __thread unsigned long alloc_count = 0;
+
+extern "C" unsigned long nubot_alloc_count(void)
+{
+    return alloc_count;
+}
+
+static void* counted_malloc(std::size_t size)
+{
+    alloc_count++;
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+    void* p = counted_malloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    void* p = counted_malloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) throw()
+{
+    return counted_malloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) throw()
+{
+    return counted_malloc(size);
+}
+
+void operator delete(void* p) throw()
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) throw()
+{
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) throw()
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) throw()
+{
+    std::free(p);
+}
@@ -0,0 +1,20 @@
+#ifndef ALLOC_COUNTER_HH
+#define ALLOC_COUNTER_HH
+
+/// Heap allocation counter used to check that the steady-state simulation step does not allocate.
+/// The counter lives in libnubot_alloc_counter.so, which replaces operator new. It is only active
+/// when that library is preloaded, e.g.
+///     LD_PRELOAD=libnubot_alloc_counter.so roslaunch nubot_gazebo game_ready.launch
+/// or alloc_counter.cc is linked in, as in test/steady_state_allocation.cc.
+/// Without it allocation_count() always returns 0 and the check is a no-op.
+extern "C" unsigned long nubot_alloc_count(void) __attribute__((weak));
+
+namespace gazebo{
+  /// \brief Number of heap allocations made by the calling thread so far
+  inline unsigned long allocation_count(void)
+  {
+      return nubot_alloc_count ? nubot_alloc_count() : 0;
+  }
+}
+
+#endif //! ALLOC_COUNTER_HH
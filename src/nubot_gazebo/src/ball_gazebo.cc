@@ -19,6 +19,7 @@ using namespace gazebo;
 GZ_REGISTER_MODEL_PLUGIN(BallGazebo)
 
 BallGazebo::BallGazebo()
+    : vel_x_(0.0), vel_y_(0.0), last_vel_len_(0.0), decay_coef_(NULL), step_timer_(NULL), stats_(NULL)
 {}
 
 BallGazebo::~BallGazebo()
@@ -28,11 +29,27 @@ void BallGazebo::Load(physics::ModelPtr _parent, sdf::ElementPtr /*_sdf*/)
 {
     world_ = _parent->GetWorld();
     football_model_ = _parent;
-    rosnode_ = new ros::NodeHandle();
+
+    // "field<K>_football" belongs to field K, which may have a size of its own
+    double field_spacing;
+    ros::param::param<double>("/fields/spacing", field_spacing, 20.0);
+    field_ = parse_field(football_model_->GetName(), field_spacing);
+
+    rosnode_ = new ros::NodeHandle(field_.ns);
     rosnode_->param("/football/chassis_link",  football_chassis_,   std::string("football::ball") );
     rosnode_->param("/field/length",           field_length_,      18.0);
     rosnode_->param("/field/width",            field_width_,       12.0);
+    football_chassis_ = field_.prefix + football_chassis_;
+    if(field_.field > 0)
+    {
+        rosnode_->param(field_.ns + "/field/length",   field_length_,  field_length_);
+        rosnode_->param(field_.ns + "/field/width",    field_width_,   field_width_);
+    }
 
+    // read once here; changes arrive through the shared parameter store
+    decay_coef_ = ParamStore::Instance()->declare("/general/ball_decay_coef", 0.5);
+    step_timer_ = StepTimer::Instance();
+    stats_ = PluginStats::Instance();
 
     football_link_ = football_model_->GetLink(football_chassis_);
     if(!football_link_)
@@ -53,28 +70,26 @@ void BallGazebo::joyCallback(const sensor_msgs::Joy::ConstPtr& joy)
 
 void BallGazebo::UpdateChild()
 {
-    static math::Vector3 ball_vel(0, 0, 0);
+    StepTimer::Scope step_timer(step_timer_, world_->GetIterations());
+    PluginStats::Scope update_time(stats_, STAT_BALL_PLUGIN);
 
     detect_ball_out();
     if(std::sqrt(vel_x_*vel_x_+vel_y_*vel_y_)>1)
-    {
-      ball_vel.Set(vel_x_, vel_y_, 0);
-      football_model_->SetLinearVel(ball_vel);
-    }
-    rosnode_->param("/general/ball_decay_coef", mu_, 0.5);
+      football_model_->SetLinearVel(math::Vector3(vel_x_, vel_y_, 0));
+    mu_ = decay_coef_->get();
     ball_vel_decay(mu_);
 }
 
 void BallGazebo::ball_vel_decay(double mu)
 {
+    // one football per field, so the previous speed is kept per plugin
     math::Vector3   vel = football_model_->GetWorldLinearVel();
-    static double   last_vel_len = vel.GetLength();
     double          vel_len = vel.GetLength();
 
     if(vel_len > 0.0)
     {
         if(football_model_->GetWorldPose().pos.z <= 0.12 &&
-                !(last_vel_len - vel_len > 0) )     // when the ball is not in the air && when
+                !(last_vel_len_ - vel_len > 0) )     // when the ball is not in the air && when
                                                     // it does not decelerate anymore
         {
             double force = -mu*m*g;
@@ -87,25 +102,28 @@ void BallGazebo::ball_vel_decay(double mu)
         football_model_->SetLinearVel(math::Vector3::Zero);
     }
 
-    last_vel_len = vel_len;
+    last_vel_len_ = vel_len;
 }
 
 void BallGazebo::detect_ball_out(void)
 {
-    double pos_x = football_model_->GetWorldPose().pos.x;
-    double pos_y = football_model_->GetWorldPose().pos.y;
+    // relative to the center of this football's field
+    double pos_x = football_model_->GetWorldPose().pos.x - field_.origin_x;
+    double pos_y = football_model_->GetWorldPose().pos.y - field_.origin_y;
     int a = pos_x > 0? 1 : -1;
     int b = pos_y > 0? 1 : -1;
 
     if(fabs(pos_x)>field_length_/2.0)
     {
-        math::Pose  target_pose( math::Vector3 (a*(field_length_/2.0-0.02), pos_y, 0.12), math::Quaternion(0,0,0) );
+        math::Pose  target_pose( math::Vector3 (field_.origin_x + a*(field_length_/2.0-0.02), field_.origin_y + pos_y, 0.12),
+                                 math::Quaternion(0,0,0) );
         football_model_->SetWorldPose(target_pose);
         football_model_->SetLinearVel(math::Vector3::Zero);
     }
     else if(fabs(pos_y) > field_width_/2.0)
     {
-        math::Pose  target_pose( math::Vector3 (pos_x, b*(field_width_/2.0 - 0.02), 0.12), math::Quaternion(0,0,0) );
+        math::Pose  target_pose( math::Vector3 (field_.origin_x + pos_x, field_.origin_y + b*(field_width_/2.0 - 0.02), 0.12),
+                                 math::Quaternion(0,0,0) );
         football_model_->SetWorldPose(target_pose);
         football_model_->SetLinearVel(math::Vector3::Zero);
     }
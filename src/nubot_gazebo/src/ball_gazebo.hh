@@ -16,6 +16,10 @@
 #include <sensor_msgs/Joy.h>
 
 #include "nubot/core/core.hpp"
+#include "param_store.hh"
+#include "step_timer.hh"
+#include "plugin_stats.hh"
+#include "field_layout.hh"
 
 
 namespace gazebo{
@@ -33,9 +37,14 @@ namespace gazebo{
         std::string                 football_chassis_;
         physics::LinkPtr            football_link_;     //Pointer to the football link
 
+        field_layout                field_;             // the field this football belongs to
         double                      vel_x_;
         double                      vel_y_;
+        double                      last_vel_len_;      // speed of the previous step
         double                      mu_;                // frictional coefficient
+        const ParamValue*           decay_coef_;        // /general/ball_decay_coef; tunable at run time
+        StepTimer*                  step_timer_;        // time spent in plugins per physics step
+        PluginStats*                stats_;             // instrumentation, off unless /general/instrumentation is set
         double                      field_length_;
         double                      field_width_;
 
@@ -46,7 +55,7 @@ namespace gazebo{
         /// \param[in] mu   --  friction coefficient
         void ball_vel_decay(double mu);
 
-        /// \brief Detect whether ball is out of the field and put it in a specific position
+        /// \brief Detect whether ball is out of its field and put it in a specific position
         void detect_ball_out(void);
 
     public:
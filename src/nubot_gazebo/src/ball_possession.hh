@@ -0,0 +1,101 @@
+#ifndef BALL_POSSESSION_HH
+#define BALL_POSSESSION_HH
+
+#include "planar_state.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace gazebo{
+   /// \brief Agent of the world as seen by BallPossession
+   struct possession_agent
+   {
+       bool robot;                  // the football and other models never hold the ball
+       bool flipped;                // rival robot: its kicking mechanism points against its yaw
+       int  rank;                   // tie break; of two robots at the same distance the lower rank wins
+   };
+
+  /// \class BallPossession
+  /// \brief Decides once per step which robot of a world holds the football. A robot takes the ball
+  /// if the ball is within the dribble distance and inside the dribble angle in front of it, the
+  /// same test as RobotBehaviour::is_hold_ball() but on the noise-free state. A robot that holds the
+  /// ball keeps it until the ball leaves the thresholds widened by the hysteresis margins, so the
+  /// holder does not flicker at the boundary. If several robots pass the test and none held the
+  /// ball before, the nearest one takes it, ties going to the lower rank; the result only depends
+  /// on the state, not on the order the plugins run in. Gazebo-free.
+  class BallPossession
+  {
+    public:
+        BallPossession() : holder_(-1)
+        {
+            set_params(0.5, 30.0, 0.0, 0.0);
+        }
+
+        /// \brief Set the thresholds; may change every step
+        /// \param[in] distance_thres   largest distance from robot to ball to take it (m)
+        /// \param[in] angle_thres      angle range in front of the robot to take the ball (degree)
+        /// \param[in] distance_margin  the holder keeps the ball up to distance_thres + distance_margin (m)
+        /// \param[in] angle_margin     ... and within angle_thres + angle_margin (degree)
+        void set_params(double distance_thres, double angle_thres, double distance_margin, double angle_margin)
+        {
+            distance_thres_ = distance_thres;
+            half_angle_     = angle_thres / 2.0 * M_PI / 180.0;
+            keep_distance_  = distance_thres + distance_margin;
+            keep_half_angle_ = (angle_thres / 2.0 + angle_margin) * M_PI / 180.0;
+        }
+
+        /// \brief Describe the agents; call whenever agents are added or removed. Forgets the holder.
+        void set_agents(const std::vector<possession_agent> & agents)
+        {
+            agents_ = agents;
+            holder_ = -1;
+        }
+
+        /// \brief Forget the holder, e.g. when the ball is put back to the center
+        void reset(void) { holder_ = -1; }
+
+        /// \brief Decide the holder of this step
+        /// \param[in] ball_relative    football relative to every agent, see transform_ball_to_egos()
+        /// \return index of the robot holding the ball, -1 if none
+        int update(const EgoStates & ball_relative)
+        {
+            const unsigned int n = std::min<unsigned int>(ball_relative.size(), agents_.size());
+            if(holder_ >= (int)n || (holder_ >= 0 && !passes(ball_relative, holder_, keep_distance_, keep_half_angle_)))
+                holder_ = -1;
+            if(holder_ >= 0)
+                return holder_;
+
+            for(unsigned int i=0; i<n; i++)
+            {
+                if(!agents_[i].robot || !passes(ball_relative, i, distance_thres_, half_angle_))
+                    continue;
+                if(holder_ < 0 || ball_relative.range[i] < ball_relative.range[holder_] ||
+                   (ball_relative.range[i] == ball_relative.range[holder_] && agents_[i].rank < agents_[holder_].rank))
+                    holder_ = i;
+            }
+            return holder_;
+        }
+
+        /// \brief Result of the last update()
+        int holder(void) const { return holder_; }
+
+    private:
+        bool passes(const EgoStates & ball_relative, unsigned int i, double distance, double half_angle) const
+        {
+            double bearing = ball_relative.bearing[i];
+            if(agents_[i].flipped)
+                bearing = bearing > 0.0 ? bearing - M_PI : bearing + M_PI;
+            return ball_relative.range[i] <= distance && std::fabs(bearing) <= half_angle;
+        }
+
+        std::vector<possession_agent>   agents_;
+        double                          distance_thres_;
+        double                          half_angle_;        // rad
+        double                          keep_distance_;
+        double                          keep_half_angle_;   // rad
+        int                             holder_;
+  };
+}
+
+#endif //! BALL_POSSESSION_HH
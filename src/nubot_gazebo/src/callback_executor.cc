@@ -0,0 +1,190 @@
+#include "callback_executor.hh"
+
+#include <ros/ros.h>
+#include <boost/bind.hpp>
+
+using namespace gazebo;
+
+CallbackExecutor*   CallbackExecutor::instance_ = NULL;
+boost::mutex        CallbackExecutor::instance_lock_;
+
+static const boost::posix_time::milliseconds retry_delay(10);  // a parked queue is tried again after this
+
+StrandQueue::StrandQueue(CallbackExecutor* executor)
+    : executor_(executor), scheduled_(false), running_(false), deferred_(false), not_ready_(0), enabled_(true)
+{}
+
+StrandQueue::~StrandQueue()
+{}
+
+void StrandQueue::addCallback(const ros::CallbackInterfacePtr& callback, uint64_t owner_id)
+{
+    bool schedule = false;
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        if(!enabled_)
+            return;
+        callbacks_.push_back(callback_entry(callback, owner_id));
+        if(!scheduled_ || deferred_)
+        {
+            scheduled_ = true;
+            deferred_ = false;
+            not_ready_ = 0;
+            schedule = true;
+        }
+    }
+    if(schedule)
+        executor_->schedule(shared_from_this());
+}
+
+void StrandQueue::removeByID(uint64_t owner_id)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    for(std::deque<callback_entry>::iterator it = callbacks_.begin(); it != callbacks_.end(); )
+    {
+        if(it->second == owner_id)
+            it = callbacks_.erase(it);
+        else
+            ++it;
+    }
+}
+
+void StrandQueue::disable(void)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    enabled_ = false;
+    callbacks_.clear();
+    while(running_)
+        idle_cond_.wait(lock);
+}
+
+bool StrandQueue::run_one(void)
+{
+    ros::CallbackInterfacePtr callback;
+    uint64_t                  owner_id;
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        if(!enabled_ || callbacks_.empty())
+        {
+            scheduled_ = false;
+            return false;
+        }
+        callback = callbacks_.front().first;
+        owner_id = callbacks_.front().second;
+        callbacks_.pop_front();
+        running_ = true;
+    }
+
+    ros::CallbackInterface::CallResult result = ros::CallbackInterface::TryAgain;
+    if(callback->ready())
+        result = callback->call();
+
+    boost::mutex::scoped_lock lock(lock_);
+    running_ = false;
+    idle_cond_.notify_all();
+    if(result == ros::CallbackInterface::TryAgain && enabled_)
+    {
+        callbacks_.push_back(callback_entry(callback, owner_id));
+        not_ready_++;
+    }
+    else
+        not_ready_ = 0;
+    if(!enabled_ || callbacks_.empty())
+    {
+        scheduled_ = false;
+        return false;
+    }
+
+    // none of the pending callbacks can run now: park instead of spinning on them
+    if(not_ready_ >= callbacks_.size())
+    {
+        not_ready_ = 0;
+        deferred_ = true;
+        lock.unlock();
+        executor_->defer(shared_from_this());
+        return false;
+    }
+    return true;
+}
+
+bool StrandQueue::take_deferred(void)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    if(!deferred_)
+        return false;
+    deferred_ = false;
+    return true;
+}
+
+CallbackExecutor* CallbackExecutor::Instance(int thread_num)
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    if(!instance_)
+        instance_ = new CallbackExecutor(thread_num);
+    return instance_;
+}
+
+CallbackExecutor::CallbackExecutor(int thread_num)
+    : thread_num_(thread_num > 0 ? thread_num : 1)
+{
+    for(int i=0; i<thread_num_; i++)
+        workers_.create_thread(boost::bind(&CallbackExecutor::worker, this));
+    ROS_INFO("CallbackExecutor: serving the callback queues of all plugins with %d threads", thread_num_);
+}
+
+StrandQueuePtr CallbackExecutor::create_queue(void)
+{
+    return StrandQueuePtr(new StrandQueue(this));
+}
+
+void CallbackExecutor::schedule(const StrandQueuePtr & queue)
+{
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        ready_.push_back(queue);
+    }
+    ready_cond_.notify_one();
+}
+
+void CallbackExecutor::defer(const StrandQueuePtr & queue)
+{
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        deferred_.push_back(std::make_pair(boost::get_system_time() + retry_delay, queue));
+    }
+    ready_cond_.notify_one();
+}
+
+void CallbackExecutor::worker(void)
+{
+    while(true)
+    {
+        StrandQueuePtr queue;
+        {
+            boost::mutex::scoped_lock lock(lock_);
+            while(true)
+            {
+                // parked queues whose retry delay has passed; the delay is constant, so they are in order
+                const boost::system_time now = boost::get_system_time();
+                while(!deferred_.empty() && deferred_.front().first <= now)
+                {
+                    if(deferred_.front().second->take_deferred())
+                        ready_.push_back(deferred_.front().second);
+                    deferred_.pop_front();
+                }
+                if(!ready_.empty())
+                    break;
+                if(deferred_.empty())
+                    ready_cond_.wait(lock);
+                else
+                    ready_cond_.timed_wait(lock, deferred_.front().first);
+            }
+            queue = ready_.front();
+            ready_.pop_front();
+        }
+
+        // run one callback, then let other queues take their turn
+        if(queue->run_one())
+            schedule(queue);
+    }
+}
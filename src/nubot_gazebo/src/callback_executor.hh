@@ -0,0 +1,115 @@
+#ifndef CALLBACK_EXECUTOR_HH
+#define CALLBACK_EXECUTOR_HH
+
+#include <ros/callback_queue_interface.h>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/thread_time.hpp>
+#include <deque>
+#include <utility>
+
+namespace gazebo{
+  class CallbackExecutor;
+
+  /// \class StrandQueue
+  /// \brief Callback queue of one plugin, served by the process-wide CallbackExecutor.
+  /// Callbacks of one queue run one at a time and in order, so the fields they write
+  /// have a single writer; different queues run concurrently. If no pending callback is
+  /// ready, the queue is parked until a callback is added or a short retry delay has passed.
+  class StrandQueue : public ros::CallbackQueueInterface,
+                      public boost::enable_shared_from_this<StrandQueue>
+  {
+    public:
+        /// \param[in] executor     executor running the callbacks
+        explicit StrandQueue(CallbackExecutor* executor);
+
+        virtual ~StrandQueue();
+
+        /// \brief Add a callback and wake up a worker. Called by roscpp.
+        virtual void addCallback(const ros::CallbackInterfacePtr& callback, uint64_t owner_id=0);
+
+        /// \brief Remove all callbacks of an owner. Called by roscpp.
+        virtual void removeByID(uint64_t owner_id);
+
+        /// \brief Drop all pending callbacks and ignore new ones. Waits for a running callback
+        /// to return, so the owner can be destroyed afterwards.
+        void disable(void);
+
+        /// \brief Number of pending callbacks
+        unsigned int size(void)
+        {
+            boost::mutex::scoped_lock lock(lock_);
+            return callbacks_.size();
+        }
+
+    private:
+        friend class CallbackExecutor;
+
+        /// \brief Run the first callback. Called by an executor worker.
+        /// \return true if more callbacks are pending and the queue has to be scheduled again;
+        /// false if it is empty or has been parked
+        bool run_one(void);
+
+        /// \brief End the parking of the queue when its retry delay has passed. Called by the executor.
+        /// \return false if a new callback has already ended it
+        bool take_deferred(void);
+
+        typedef std::pair<ros::CallbackInterfacePtr, uint64_t> callback_entry;
+
+        CallbackExecutor*           executor_;
+        boost::mutex                lock_;
+        boost::condition_variable   idle_cond_;         // signaled when a running callback returns
+        std::deque<callback_entry>  callbacks_;
+        bool                        scheduled_;         // queued in the executor or being run by a worker
+        bool                        running_;           // a callback is running
+        bool                        deferred_;          // parked: no pending callback was ready
+        unsigned int                not_ready_;         // callbacks found not ready since the last one ran
+        bool                        enabled_;
+  };
+
+  typedef boost::shared_ptr<StrandQueue> StrandQueuePtr;
+
+  /// \class CallbackExecutor
+  /// \brief A fixed number of worker threads serving the callback queues of all plugins
+  /// in the gzserver process. Workers sleep on a condition variable and are woken up
+  /// as soon as a callback arrives, instead of polling each queue with a timeout.
+  class CallbackExecutor
+  {
+    public:
+        /// \brief Get the process-wide executor. It is created by the first caller.
+        /// \param[in] thread_num   number of worker threads; only used by the first caller
+        static CallbackExecutor* Instance(int thread_num);
+
+        /// \brief Create a queue served by this executor
+        StrandQueuePtr create_queue(void);
+
+        /// \brief Put a queue with pending callbacks in the ready list
+        void schedule(const StrandQueuePtr & queue);
+
+        /// \brief Put a parked queue in the ready list after the retry delay
+        void defer(const StrandQueuePtr & queue);
+
+        int thread_num(void) const { return thread_num_; }
+
+    private:
+        explicit CallbackExecutor(int thread_num);
+
+        /// \brief Worker thread
+        void worker(void);
+
+        static CallbackExecutor*    instance_;
+        static boost::mutex         instance_lock_;
+
+        boost::mutex                lock_;
+        boost::condition_variable   ready_cond_;        // signaled when a queue becomes ready
+        std::deque<StrandQueuePtr>  ready_;             // queues with pending callbacks
+        std::deque<std::pair<boost::system_time, StrandQueuePtr> > deferred_;  // parked queues by retry time
+        boost::thread_group         workers_;
+        int                         thread_num_;
+  };
+}
+
+#endif //! CALLBACK_EXECUTOR_HH
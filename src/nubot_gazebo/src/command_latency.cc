@@ -0,0 +1,85 @@
+#include "command_latency.hh"
+
+#include <cmath>
+
+using namespace gazebo;
+
+static const double velocity_tolerance = 0.05;  // actual velocity this close to the command counts as taken effect (m/s, rad/s)
+static const double effect_timeout = 1.0;       // a command not in effect after this long is counted as lost (s, simulated)
+
+static const char* stage_names[LATENCY_STAGES] = {"transport", "dispatch", "effect", "end to end"};
+
+static uint64_t to_ns(double seconds)
+{
+    return seconds > 0.0 ? (uint64_t)(seconds * 1e9) : 0;
+}
+
+CommandLatency::CommandLatency()
+    : applied_count_(0), lost_count_(0), pending_(false), seq_(0), sent_(0.0), applied_sim_time_(0.0),
+      target_vx_(0.0), target_vy_(0.0), target_w_(0.0)
+{}
+
+void CommandLatency::applied(uint32_t seq, double sent, double received, double applied, double sim_time,
+                             double vx, double vy, double w)
+{
+    if(pending_)                                // replaced before it took effect
+        lost_count_++;
+
+    histograms_[LATENCY_TRANSPORT].add(to_ns(received - sent));
+    histograms_[LATENCY_DISPATCH].add(to_ns(applied - received));
+    applied_count_++;
+
+    pending_ = true;
+    seq_ = seq;
+    sent_ = sent;
+    applied_sim_time_ = sim_time;
+    target_vx_ = vx;
+    target_vy_ = vy;
+    target_w_  = w;
+}
+
+void CommandLatency::observe(double wall_time, double sim_time, double vx, double vy, double w)
+{
+    if(!pending_ || sim_time <= applied_sim_time_)
+        return;
+
+    if(std::fabs(vx - target_vx_) < velocity_tolerance && std::fabs(vy - target_vy_) < velocity_tolerance &&
+       std::fabs(w - target_w_) < velocity_tolerance)
+    {
+        histograms_[LATENCY_EFFECT].add(to_ns(sim_time - applied_sim_time_));
+        histograms_[LATENCY_END_TO_END].add(to_ns(wall_time - sent_));
+        pending_ = false;
+    }
+    else if(sim_time - applied_sim_time_ > effect_timeout)     // e.g. blocked by another robot
+    {
+        lost_count_++;
+        pending_ = false;
+    }
+}
+
+bool CommandLatency::report(diagnostic_msgs::DiagnosticStatus & status)
+{
+    if(applied_count_ == 0)
+        return false;
+
+    // filled in place, so a robot's steady-state step does not allocate for it
+    status.message = "ms";
+    status.values.resize(3 + 3 * LATENCY_STAGES);
+    set_diagnostic_value(status, 0, "commands", applied_count_);
+    set_diagnostic_value(status, 1, "lost", lost_count_);
+    set_diagnostic_value(status, 2, "last seq", seq_);
+    StatHistogram::snapshot snapshot;
+    char key[32];
+    for(int i=0; i<LATENCY_STAGES; i++)
+    {
+        histograms_[i].take(snapshot);
+        snprintf(key, sizeof(key), "%s p50", stage_names[i]);
+        set_diagnostic_value(status, 3 + 3 * i, key, snapshot.quantile(0.50) * 1e-6);
+        snprintf(key, sizeof(key), "%s p99", stage_names[i]);
+        set_diagnostic_value(status, 4 + 3 * i, key, snapshot.quantile(0.99) * 1e-6);
+        snprintf(key, sizeof(key), "%s max", stage_names[i]);
+        set_diagnostic_value(status, 5 + 3 * i, key, snapshot.max * 1e-6);
+    }
+    applied_count_ = lost_count_ = 0;
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef COMMAND_LATENCY_HH
+#define COMMAND_LATENCY_HH
+
+#include <diagnostic_msgs/DiagnosticStatus.h>
+
+#include "plugin_stats.hh"
+
+#include <stdint.h>
+#include <string>
+
+namespace gazebo{
+   /// \brief Stages of a stamped velocity command
+   enum latency_stage
+   {
+       LATENCY_TRANSPORT,       // sent by the controller -> taken by the velcmd callback (wall time)
+       LATENCY_DISPATCH,        // taken by the callback -> applied by the physics thread (wall time)
+       LATENCY_EFFECT,          // applied -> robot observed moving as commanded (simulated time)
+       LATENCY_END_TO_END,      // sent -> robot observed moving as commanded (wall time)
+       LATENCY_STAGES
+   };
+
+  /// \class CommandLatency
+  /// \brief Traces stamped velocity commands (nubot_common/VelCmdStamped) of one robot from the
+  /// controller to the physics: when the command was sent, received, applied in a physics step
+  /// and when the robot was first seen moving at the commanded velocity. Each stage goes into a
+  /// histogram; report() turns them into p50/p99/max. A large transport share points at the
+  /// ROS transport, a large dispatch share at a busy physics thread, a large end-to-end time
+  /// with small stages at a CPU-bound controller. Physics thread only.
+  class CommandLatency
+  {
+    public:
+        CommandLatency();
+
+        /// \brief A stamped command has been applied in this physics step
+        /// \param[in] seq          command id
+        /// \param[in] sent         wall time the controller sent the command (s)
+        /// \param[in] received     wall time the velcmd callback took it (s)
+        /// \param[in] applied      wall time of this physics step (s)
+        /// \param[in] sim_time     simulated time of this physics step (s)
+        /// \param[in] vx, vy, w    velocity set on the robot, world frame (m/s, rad/s)
+        void applied(uint32_t seq, double sent, double received, double applied, double sim_time,
+                     double vx, double vy, double w);
+
+        /// \brief Compare the robot's actual velocity in this step with the last applied command
+        /// \param[in] wall_time    wall time of this physics step (s)
+        /// \param[in] sim_time     simulated time of this physics step (s)
+        /// \param[in] vx, vy, w    actual velocity of the robot, world frame (m/s, rad/s)
+        void observe(double wall_time, double sim_time, double vx, double vy, double w);
+
+        /// \brief Fill a diagnostic status with p50, p99 and max of every stage (ms) and clear the
+        /// histograms
+        /// \return false if no stamped command was applied since the last report
+        bool report(diagnostic_msgs::DiagnosticStatus & status);
+
+    private:
+        StatHistogram   histograms_[LATENCY_STAGES];    // in ns
+        unsigned long   applied_count_;                 // stamped commands applied since the last report
+        unsigned long   lost_count_;                    // ... superseded or timed out before taking effect
+        bool            pending_;                       // last applied command has not taken effect yet
+        uint32_t        seq_;
+        double          sent_;                          // of the pending command, wall time (s)
+        double          applied_sim_time_;              // of the pending command, simulated time (s)
+        double          target_vx_, target_vy_, target_w_;
+  };
+}
+
+#endif //! COMMAND_LATENCY_HH
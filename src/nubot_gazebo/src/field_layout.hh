@@ -0,0 +1,67 @@
+/* Desc: Several fields in one world. Models of field K > 0 are named "field<K>_<name>",
+ *       e.g. field2_nubot1 and field2_football; unprefixed models belong to field 0.
+ *       Field K is shifted by K * /fields/spacing along y. Gazebo-free.
+ */
+
+#ifndef FIELD_LAYOUT_HH
+#define FIELD_LAYOUT_HH
+
+#include <cctype>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace gazebo{
+   /// \brief The field a model belongs to, resolved from its name
+   struct field_layout
+   {
+       int          field;          // 0 for unprefixed models
+       std::string  prefix;         // model name prefix of the field, e.g. "field2_"; empty for field 0
+       std::string  ns;             // ROS namespace prefix of the field, e.g. "/field2"; empty for field 0
+       std::string  local_name;     // model name without the field prefix, e.g. "nubot1"
+       double       origin_x;       // center of the field in the world frame (m)
+       double       origin_y;
+   };
+
+   /// \brief Model name prefix of a field
+   inline std::string field_prefix(int field)
+   {
+       if(field <= 0)
+           return std::string();
+       std::ostringstream prefix;
+       prefix << "field" << field << "_";
+       return prefix.str();
+   }
+
+   /// \brief Work out the field of a model from its name
+   /// \param[in] name      model name, e.g. "field2_nubot1" or "nubot1"
+   /// \param[in] spacing   distance between the centers of neighbouring fields (m)
+   inline field_layout parse_field(const std::string & name, double spacing)
+   {
+       field_layout layout;
+       layout.field = 0;
+       layout.local_name = name;
+
+       // "field" <digits> "_" <rest>; anything else is a model of field 0
+       static const std::string tag("field");
+       unsigned int end = tag.size();
+       if(name.compare(0, tag.size(), tag) == 0)
+       {
+           while(end < name.size() && isdigit(name[end]))
+               end++;
+           if(end > tag.size() && end + 1 < name.size() && name[end] == '_' && atoi(name.c_str() + tag.size()) > 0)
+           {
+               layout.field = atoi(name.c_str() + tag.size());
+               layout.local_name = name.substr(end + 1);
+           }
+       }
+
+       layout.prefix = field_prefix(layout.field);
+       layout.ns = layout.field > 0 ? "/" + layout.prefix.substr(0, layout.prefix.size() - 1) : std::string();
+       layout.origin_x = 0.0;
+       layout.origin_y = layout.field * spacing;
+       return layout;
+   }
+}
+
+#endif //! FIELD_LAYOUT_HH
@@ -0,0 +1,28 @@
+#ifndef FORMATION_HH
+#define FORMATION_HH
+
+namespace gazebo{
+   /// \brief Start positions of the robots, world frame (m); the tables of scripts/robot_up.sh.
+   /// Entry i belongs to robot i; entry 0 is not used.
+   static const int    formation_size = 6;
+   static const double cyan_formation_x[formation_size]    = {0, -2.78, -1.5, -1.5, -5, -5};
+   static const double cyan_formation_y[formation_size]    = {0,  0,     1,   -1,    2, -2};
+   static const double magenta_formation_x[formation_size] = {0,  2.78,  1.5,  1.5,  5,  5};
+   static const double magenta_formation_y[formation_size] = {0,  0,     1,   -1,    2, -2};
+
+   /// \brief Start position of a robot as spawned by robot_up.sh
+   /// \param[in]  magenta     magenta (rival) robot
+   /// \param[in]  agent_id    robot id, 1..formation_size-1
+   /// \param[out] x,y         position in world frame (m)
+   /// \return false if robot_up.sh has no position for this id
+   inline bool formation_position(bool magenta, int agent_id, double & x, double & y)
+   {
+       if(agent_id < 1 || agent_id >= formation_size)
+           return false;
+       x = magenta ? magenta_formation_x[agent_id] : cyan_formation_x[agent_id];
+       y = magenta ? magenta_formation_y[agent_id] : cyan_formation_y[agent_id];
+       return true;
+   }
+}
+
+#endif //! FORMATION_HH
@@ -0,0 +1,225 @@
+#include "kinematic_world.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace gazebo;
+
+static const double g = 9.8;                            // gravity coefficient
+static const double robot_radius = 0.26;                // footprint of a robot (m)
+static const double robot_height = 0.8;                 // the football passes over robots above this (m)
+static const double ball_radius = 0.11;
+static const double ball_ground_z = 0.12;               // height of the football lying on the ground, as in BallGazebo
+static const double ball_restitution = 0.5;             // share of the normal velocity kept on bounces
+static const double carpet_margin = 1.0;                // robots may leave the field this far (m)
+static const double goal_width = 2.4;                   // distance between the goal posts (m)
+static const double goal_height = 1.0;
+
+KinematicWorld::KinematicWorld()
+{
+    configure(18.0, 12.0, 0.01, 0.5);
+}
+
+void KinematicWorld::configure(double field_length, double field_width, double step_size, double ball_decay_coef)
+{
+    field_length_ = field_length;
+    field_width_ = field_width;
+    dt_ = step_size;
+    mu_ = ball_decay_coef;
+    sim_time_ = 0.0;
+    iterations_ = 0;
+    goal_ = 0;
+
+    // only the football
+    states_.resize(1);
+    cmd_vx_.clear(); cmd_vy_.clear(); cmd_w_.clear();
+    last_x_.clear(); last_y_.clear();
+    place_ball(0.0, 0.0);
+}
+
+unsigned int KinematicWorld::add_robot(double x, double y, double yaw)
+{
+    // the football stays the last entry
+    const unsigned int robot = robot_num();
+    const unsigned int n = states_.size() + 1;
+    states_.resize(n);
+    states_.x[n-1] = states_.x[robot];   states_.y[n-1] = states_.y[robot];
+    states_.vx[n-1] = states_.vx[robot]; states_.vy[n-1] = states_.vy[robot];
+    states_.yaw[n-1] = states_.w[n-1] = 0.0;
+
+    cmd_vx_.push_back(0.0); cmd_vy_.push_back(0.0); cmd_w_.push_back(0.0);
+    last_x_.push_back(x);   last_y_.push_back(y);
+    place_robot(robot, x, y, yaw);
+    return robot;
+}
+
+void KinematicWorld::place_robot(unsigned int robot, double x, double y, double yaw)
+{
+    states_.x[robot] = last_x_[robot] = x;
+    states_.y[robot] = last_y_[robot] = y;
+    states_.yaw[robot] = yaw;
+    states_.vx[robot] = states_.vy[robot] = states_.w[robot] = 0.0;
+    cmd_vx_[robot] = cmd_vy_[robot] = cmd_w_[robot] = 0.0;
+}
+
+void KinematicWorld::place_ball(double x, double y)
+{
+    set_ball_pose(x, y, ball_ground_z);
+}
+
+void KinematicWorld::set_robot_velocity(unsigned int robot, double vx, double vy, double w)
+{
+    cmd_vx_[robot] = vx;
+    cmd_vy_[robot] = vy;
+    cmd_w_[robot]  = w;
+}
+
+void KinematicWorld::set_ball_pose(double x, double y, double z)
+{
+    const unsigned int ball = ball_index();
+    states_.x[ball] = x;
+    states_.y[ball] = y;
+    states_.ball_z = z;
+    set_ball_velocity(0.0, 0.0, 0.0);
+}
+
+void KinematicWorld::set_ball_velocity(double vx, double vy, double vz)
+{
+    const unsigned int ball = ball_index();
+    states_.vx[ball] = vx;
+    states_.vy[ball] = vy;
+    states_.ball_vz = vz;
+}
+
+void KinematicWorld::step(void)
+{
+    const unsigned int robots = robot_num();
+    const unsigned int ball = ball_index();
+    const double max_x = field_length_/2.0 + carpet_margin;
+    const double max_y = field_width_/2.0 + carpet_margin;
+
+    // holonomic robots follow their commands exactly
+    for(unsigned int i=0; i<robots; i++)
+    {
+        last_x_[i] = states_.x[i];
+        last_y_[i] = states_.y[i];
+        states_.x[i] = std::max(-max_x, std::min(max_x, states_.x[i] + cmd_vx_[i]*dt_));
+        states_.y[i] = std::max(-max_y, std::min(max_y, states_.y[i] + cmd_vy_[i]*dt_));
+        states_.yaw[i] = std::atan2(std::sin(states_.yaw[i] + cmd_w_[i]*dt_), std::cos(states_.yaw[i] + cmd_w_[i]*dt_));
+        states_.w[i] = cmd_w_[i];
+    }
+
+    // the football flies under gravity and rolls with friction on the ground
+    double & vx = states_.vx[ball];
+    double & vy = states_.vy[ball];
+    if(states_.ball_z > ball_ground_z || states_.ball_vz > 0.0)
+    {
+        states_.ball_vz -= g*dt_;
+        states_.ball_z  += states_.ball_vz*dt_;
+        if(states_.ball_z <= ball_ground_z)
+        {
+            states_.ball_z = ball_ground_z;
+            states_.ball_vz = states_.ball_vz < -1.0 ? -ball_restitution*states_.ball_vz : 0.0;
+        }
+    }
+    else
+    {
+        states_.ball_z = ball_ground_z;
+        states_.ball_vz = 0.0;
+        double vel_len = std::sqrt(vx*vx + vy*vy);
+        double decay = mu_*g*dt_;
+        double scale = vel_len > decay ? (vel_len - decay)/vel_len : 0.0;
+        vx *= scale;
+        vy *= scale;
+    }
+    states_.x[ball] += vx*dt_;
+    states_.y[ball] += vy*dt_;
+
+    collide();
+    detect_ball_out();
+
+    // actual velocities of the robots, after they have been pushed apart
+    for(unsigned int i=0; i<robots; i++)
+    {
+        states_.vx[i] = (states_.x[i] - last_x_[i])/dt_;
+        states_.vy[i] = (states_.y[i] - last_y_[i])/dt_;
+    }
+
+    sim_time_ += dt_;
+    iterations_++;
+}
+
+void KinematicWorld::collide(void)
+{
+    const unsigned int robots = robot_num();
+    const unsigned int ball = ball_index();
+    const double robot_dist = 2*robot_radius;
+    const double ball_dist = robot_radius + ball_radius;
+
+    // robots push each other apart, half the overlap each
+    for(unsigned int i=0; i<robots; i++)
+        for(unsigned int j=i+1; j<robots; j++)
+        {
+            double dx = states_.x[j] - states_.x[i];
+            double dy = states_.y[j] - states_.y[i];
+            double dist2 = dx*dx + dy*dy;
+            if(dist2 >= robot_dist*robot_dist)
+                continue;
+            double dist = std::sqrt(dist2);
+            if(dist < 1e-9)
+            {
+                dx = 1.0; dy = 0.0; dist = 1.0;
+            }
+            double push = 0.5*(robot_dist - dist)/dist;
+            states_.x[i] -= dx*push;  states_.y[i] -= dy*push;
+            states_.x[j] += dx*push;  states_.y[j] += dy*push;
+        }
+
+    // the football bounces off robots unless it flies over them
+    if(states_.ball_z - ball_radius > robot_height)
+        return;
+    for(unsigned int i=0; i<robots; i++)
+    {
+        double dx = states_.x[ball] - states_.x[i];
+        double dy = states_.y[ball] - states_.y[i];
+        double dist2 = dx*dx + dy*dy;
+        if(dist2 >= ball_dist*ball_dist)
+            continue;
+        double dist = std::sqrt(dist2);
+        if(dist < 1e-9)
+        {
+            dx = 1.0; dy = 0.0; dist = 1.0;
+        }
+        double nx = dx/dist, ny = dy/dist;
+        states_.x[ball] = states_.x[i] + nx*ball_dist;
+        states_.y[ball] = states_.y[i] + ny*ball_dist;
+
+        // reflect the velocity relative to the robot if the football moves into it
+        double rvx = states_.vx[ball] - cmd_vx_[i];
+        double rvy = states_.vy[ball] - cmd_vy_[i];
+        double vn = rvx*nx + rvy*ny;
+        if(vn < 0.0)
+        {
+            states_.vx[ball] -= (1.0 + ball_restitution)*vn*nx;
+            states_.vy[ball] -= (1.0 + ball_restitution)*vn*ny;
+        }
+    }
+}
+
+void KinematicWorld::detect_ball_out(void)
+{
+    const unsigned int ball = ball_index();
+    double pos_x = states_.x[ball];
+    double pos_y = states_.y[ball];
+    int a = pos_x > 0? 1 : -1;
+    int b = pos_y > 0? 1 : -1;
+
+    goal_ = 0;
+    if(std::fabs(pos_x) > field_length_/2.0 && std::fabs(pos_y) < goal_width/2.0 &&
+       states_.ball_z < goal_height)
+        goal_ = a;
+    else if(std::fabs(pos_x) > field_length_/2.0)
+        set_ball_pose(a*(field_length_/2.0-0.02), pos_y, ball_ground_z);
+    else if(std::fabs(pos_y) > field_width_/2.0)
+        set_ball_pose(pos_x, b*(field_width_/2.0 - 0.02), ball_ground_z);
+}
@@ -0,0 +1,112 @@
+#ifndef KINEMATIC_WORLD_HH
+#define KINEMATIC_WORLD_HH
+
+#include "physics_backend.hh"
+#include "planar_state.hh"
+
+#include <vector>
+
+namespace gazebo{
+  /// \class KinematicWorld
+  /// \brief A 2D kinematic stand-in for the Gazebo world: holonomic robots that follow their
+  /// velocity commands, a football with rolling friction and gravity, circle-circle collisions
+  /// and the field bounds of BallGazebo::detect_ball_out(). Gazebo- and ROS-free, and cheap
+  /// enough to run a match thousands of times faster than real time on one core.
+  /// Entries 0..robot_num()-1 of states() are the robots, the last entry is the football.
+  class KinematicWorld
+  {
+    public:
+        KinematicWorld();
+
+        /// \brief Set up the world; removes all robots
+        /// \param[in] field_length, field_width    size of the field (m), as /field/length and /field/width
+        /// \param[in] step_size                    simulated time per step (s)
+        /// \param[in] ball_decay_coef              rolling friction coefficient of the football
+        void configure(double field_length, double field_width, double step_size, double ball_decay_coef);
+
+        /// \brief Add a robot at rest
+        /// \return index of the robot in states()
+        unsigned int add_robot(double x, double y, double yaw);
+
+        /// \brief Put a robot somewhere else and stop it
+        void place_robot(unsigned int robot, double x, double y, double yaw);
+
+        /// \brief Put the football somewhere else and stop it
+        void place_ball(double x, double y);
+
+        void set_ball_decay_coef(double mu) { mu_ = mu; }
+
+        /// \brief Advance the world by one step
+        void step(void);
+
+        /// \brief Goal scored in the last step: 1 if the football entered the goal at +x, -1 at -x,
+        /// 0 if none. The football is left behind the goal line; put it back with place_ball().
+        int goal(void) const { return goal_; }
+
+        /// \brief States of the robots and the football, world frame, actual (not commanded) velocities
+        const PlanarStates & states(void) const { return states_; }
+
+        unsigned int robot_num(void) const { return states_.size() - 1; }
+        unsigned int ball_index(void) const { return states_.size() - 1; }
+        double sim_time(void) const { return sim_time_; }
+        unsigned long iterations(void) const { return iterations_; }
+        double step_size(void) const { return dt_; }
+        double field_length(void) const { return field_length_; }
+        double field_width(void) const { return field_width_; }
+
+        /// \brief PhysicsBackend calls for robot i; see KinematicRobot
+        void set_robot_velocity(unsigned int robot, double vx, double vy, double w);
+        void set_ball_pose(double x, double y, double z);
+        void set_ball_velocity(double vx, double vy, double vz);
+
+    private:
+        /// \brief Keep robots and the football apart
+        void collide(void);
+
+        /// \brief Keep the football on the field, as BallGazebo::detect_ball_out(), unless it
+        /// crossed the goal line between the posts and below the bar
+        void detect_ball_out(void);
+
+        PlanarStates            states_;
+        std::vector<double>     cmd_vx_, cmd_vy_, cmd_w_;      // commanded velocities of the robots
+        std::vector<double>     last_x_, last_y_;              // positions before the step, for actual velocities
+        double                  field_length_;
+        double                  field_width_;
+        double                  dt_;
+        double                  mu_;
+        double                  sim_time_;
+        unsigned long           iterations_;
+        int                     goal_;
+  };
+
+  /// \class KinematicRobot
+  /// \brief PhysicsBackend of one robot in a KinematicWorld
+  class KinematicRobot : public PhysicsBackend
+  {
+    public:
+        KinematicRobot(KinematicWorld * world, unsigned int robot) : world_(world), robot_(robot) {}
+
+        virtual void set_robot_velocity(double vx, double vy, double w)
+        {
+            world_->set_robot_velocity(robot_, vx, vy, w);
+        }
+
+        virtual double robot_height(void) const { return 0.0; }
+
+        virtual void set_ball_pose(double x, double y, double z, double /*yaw*/)
+        {
+            world_->set_ball_pose(x, y, z);
+        }
+
+        virtual void set_ball_velocity(double vx, double vy, double vz)
+        {
+            world_->set_ball_velocity(vx, vy, vz);
+        }
+
+    private:
+        KinematicWorld *        world_;
+        unsigned int            robot_;
+  };
+}
+
+#endif //! KINEMATIC_WORLD_HH
@@ -0,0 +1,104 @@
+#include "lockstep_server.hh"
+
+#include <boost/bind.hpp>
+
+using namespace gazebo;
+
+LockstepServer*     LockstepServer::instance_ = NULL;
+boost::mutex        LockstepServer::instance_lock_;
+
+LockstepServer* LockstepServer::Instance(physics::WorldPtr world)
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    if(!instance_)
+        instance_ = new LockstepServer(world);
+    return instance_;
+}
+
+LockstepServer::LockstepServer(physics::WorldPtr world)
+    : world_(world), started_(false), real_time_update_rate_(0.0), was_paused_(false)
+{
+    int callback_threads;
+    rosnode_.param<int>("/general/callback_threads", callback_threads, 2);
+    queue_ = CallbackExecutor::Instance(callback_threads)->create_queue();
+
+    ros::AdvertiseServiceOptions aso = ros::AdvertiseServiceOptions::create<nubot_common::StepWorld>(
+                "/lockstep/step_world", boost::bind(&LockstepServer::step_world_service, this, _1, _2),
+                ros::VoidPtr(), queue_.get());
+    step_world_server_ = rosnode_.advertiseService(aso);
+    ROS_INFO("LockstepServer: serving /lockstep/step_world; the world is paused on the first request");
+}
+
+void LockstepServer::add_robot(const std::string & name, LockstepRobot* robot)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    robots_[name] = robot;
+}
+
+void LockstepServer::remove_robot(const std::string & name)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    robots_.erase(name);
+}
+
+bool LockstepServer::step_world_service(nubot_common::StepWorld::Request  &req,
+                                        nubot_common::StepWorld::Response &res)
+{
+    physics::PhysicsEnginePtr engine = world_->GetPhysicsEngine();
+    if(!started_)
+    {
+        // from now on the world only moves on requests, as fast as it can, until a release
+        was_paused_ = world_->IsPaused();
+        real_time_update_rate_ = engine->GetRealTimeUpdateRate();
+        world_->SetPaused(true);
+        engine->SetRealTimeUpdateRate(0.0);
+        started_ = true;
+    }
+
+    res.success = true;
+    {
+        // a robot unregisters before it is destroyed, so it is valid while it is in robots_
+        boost::mutex::scoped_lock lock(lock_);
+        for(unsigned int i=0; i<req.commands.size(); i++)
+        {
+            std::map<std::string, LockstepRobot*>::iterator it = robots_.find(req.commands[i].robot);
+            if(it == robots_.end())
+            {
+                res.success = false;
+                res.message += "unknown robot " + req.commands[i].robot + "; ";
+                continue;
+            }
+            it->second->lockstep_command(req.commands[i]);
+        }
+    }
+
+    // blocks until the steps are done; the world is paused again afterwards.
+    // lock_ is not held here, since models may be deleted by the physics thread.
+    if(req.ticks > 0)
+        world_->Step(req.ticks);
+
+    boost::mutex::scoped_lock lock(lock_);
+    res.sim_time = world_->GetSimTime().Double();
+    res.robots.resize(robots_.size());
+    res.omni_info.resize(robots_.size());
+    res.BallIsHolding.resize(robots_.size());
+    unsigned int i = 0;
+    for(std::map<std::string, LockstepRobot*>::iterator it = robots_.begin(); it != robots_.end(); ++it, i++)
+    {
+        bool is_hold_ball = false;
+        res.robots[i] = it->first;
+        it->second->lockstep_state(res.omni_info[i], is_hold_ball);
+        res.BallIsHolding[i] = is_hold_ball;
+    }
+
+    // the state is taken; the world may run on its own again
+    if(req.release)
+    {
+        engine->SetRealTimeUpdateRate(real_time_update_rate_);
+        world_->SetPaused(was_paused_);
+        started_ = false;
+        ROS_INFO("LockstepServer: released the world at %.3f s, real-time update rate %.1f Hz",
+                 res.sim_time, real_time_update_rate_);
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+#ifndef LOCKSTEP_SERVER_HH
+#define LOCKSTEP_SERVER_HH
+
+#include <gazebo/physics/physics.hh>
+#include <ros/ros.h>
+#include <nubot_common/ActuatorCmd.h>
+#include <nubot_common/OminiVisionInfo.h>
+#include <nubot_common/StepWorld.h>
+
+#include "callback_executor.hh"
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <string>
+
+namespace gazebo{
+  /// \class LockstepRobot
+  /// \brief What the lockstep server needs from a robot plugin
+  class LockstepRobot
+  {
+    public:
+        virtual ~LockstepRobot() {}
+
+        /// \brief Hand a command over through the same paths as the velcmd topic and the
+        /// BallHandle and Shoot services. Called while the world is paused.
+        virtual void lockstep_command(const nubot_common::ActuatorCmd & cmd) = 0;
+
+        /// \brief Get the OmniVisionInfo of the current step. Called while the world is paused.
+        virtual void lockstep_state(nubot_common::OminiVisionInfo & info, bool & is_hold_ball) = 0;
+  };
+
+  /// \class LockstepServer
+  /// \brief Runs the world in lockstep with an external client, e.g. for training or parameter
+  /// sweeps. Each call of the service /lockstep/step_world applies the commands of the request,
+  /// runs the requested number of physics steps as fast as the CPU allows and returns the state of
+  /// every robot. The world stays paused in between. A request with release set hands the world
+  /// back after its steps, with the real-time update rate and pause state it had before the first
+  /// request; the next request starts lockstep again. Enabled with the parameter /general/lockstep.
+  class LockstepServer
+  {
+    public:
+        /// \brief Get the server of a world. It is created by the first caller.
+        static LockstepServer* Instance(physics::WorldPtr world);
+
+        /// \brief Register a robot plugin. Called at load time.
+        void add_robot(const std::string & name, LockstepRobot* robot);
+
+        /// \brief Unregister a robot plugin. Called when the plugin is destroyed.
+        void remove_robot(const std::string & name);
+
+    private:
+        explicit LockstepServer(physics::WorldPtr world);
+
+        bool step_world_service(nubot_common::StepWorld::Request  &req,
+                                nubot_common::StepWorld::Response &res);
+
+        static LockstepServer*      instance_;
+        static boost::mutex         instance_lock_;
+
+        physics::WorldPtr           world_;
+        ros::NodeHandle             rosnode_;
+        ros::ServiceServer          step_world_server_;
+        StrandQueuePtr              queue_;
+        boost::mutex                lock_;              // guards robots_
+        std::map<std::string, LockstepRobot*> robots_;  // sorted by name
+        bool                        started_;           // world has been paused for lockstep
+        double                      real_time_update_rate_; // of the world before lockstep started
+        bool                        was_paused_;        // the world was paused before lockstep started
+  };
+}
+
+#endif //! LOCKSTEP_SERVER_HH
@@ -0,0 +1,151 @@
+#include "match_runner.hh"
+#include "formation.hh"
+#include "team_behaviour.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+using namespace gazebo;
+
+static const double control_rate = 50.0;        // Hz, rospy.Rate of strategy.py
+
+Match::Match(const match_config & config)
+    : config_(config)
+{
+    world_.configure(config_.field_length, config_.field_width, config_.step_size, config_.ball_decay_coef);
+    control_scheduler_.configure(control_rate, 0.0, 0.0);
+
+    // random start positions: each team draws its formation slots of robot_up.sh in random order
+    std::mt19937_64 rng(config_.seed);
+    std::uniform_real_distribution<double> jitter(-config_.start_jitter, config_.start_jitter);
+    for(int team=0; team<2; team++)
+    {
+        const int num = team == 0 ? config_.cyan_num : config_.magenta_num;
+        std::vector<int> slots;
+        for(int i=1; i<formation_size; i++)
+            slots.push_back(i);
+        std::shuffle(slots.begin(), slots.end(), rng);
+        for(int i=0; i<num; i++)
+        {
+            double x, y;
+            if(i >= (int)slots.size() || !formation_position(team == 1, slots[i], x, y))
+            {
+                x = (team == 1 ? 1 : -1) * 0.6 * (i + 1);
+                y = -config_.field_width/2.0;
+            }
+            start_x_.push_back(x + jitter(rng));
+            start_y_.push_back(y + jitter(rng));
+            magenta_.push_back(team == 1);
+        }
+    }
+
+    const unsigned int n = start_x_.size();
+    const unsigned int stuck_capacity = (unsigned int)ceil(config_.stuck_window / std::max(config_.step_size, 1e-4)) + 2;
+    behaviours_.resize(n);
+    for(unsigned int i=0; i<n; i++)
+    {
+        unsigned int index = world_.add_robot(start_x_[i], start_y_[i], 0.0);
+        backends_.push_back(KinematicRobot(&world_, index));
+
+        // the same noise streams as NubotGazebo on field 0: team * 1000 + id; matches differ by seed
+        const int agent_id = magenta_[i] ? i - config_.cyan_num + 1 : i + 1;
+        behaviours_[i].configure(magenta_[i], config_.seed, (magenta_[i] ? 1 : 0) * 1000 + agent_id,
+                                 config_.stuck_window, stuck_capacity, config_.stuck_ratio);
+        behaviours_[i].set_params(config_.noise_scale, config_.noise_rate);
+        behaviours_[i].set_goals(-config_.field_length/2.0, 0.0, config_.field_length/2.0, 0.0);
+    }
+
+    // robots first, then the football; ties go to cyan and then to the lower id, as in WorldStateCache
+    std::vector<possession_agent> agents(world_.states().size());
+    for(unsigned int i=0; i<agents.size(); i++)
+    {
+        agents[i].robot   = i < n;
+        agents[i].flipped = agents[i].robot && magenta_[i];
+        agents[i].rank    = i;
+    }
+    possession_.set_agents(agents);
+    possession_.set_params(config_.dribble_distance_thres, config_.dribble_angle_thres,
+                           config_.possession_distance_margin, config_.possession_angle_margin);
+    dribble_.assign(n, false);
+    was_stuck_.assign(n, false);
+}
+
+void Match::kick_off(void)
+{
+    for(unsigned int i=0; i<start_x_.size(); i++)
+    {
+        world_.place_robot(i, start_x_[i], start_y_[i], 0.0);
+        behaviours_[i].reset();
+        dribble_[i] = false;
+    }
+    world_.place_ball(0.0, 0.0);
+    possession_.reset();
+}
+
+void Match::control(unsigned int robot)
+{
+    // the attacked goal is at +x of the robot's own frame
+    RobotBehaviour & behaviour = behaviours_[robot];
+    dribble_[robot] = possession_.holder() == (int)robot;   // ballhandle_client(1)
+    const actuator_command cmd = ChaseDribble::decide(behaviour.ball_range(), behaviour.ball_bearing(),
+                                                      behaviour.goal_range(RIGHT_GOAL),
+                                                      behaviour.goal_bearing(RIGHT_GOAL), dribble_[robot]);
+
+    // flipped for rival robots as in NubotGazebo::vel_cmd_CB()
+    const double sign = magenta_[robot] ? -1.0 : 1.0;
+    behaviour.move(sign * cmd.Vx, sign * cmd.Vy, cmd.w, backends_[robot]);
+}
+
+match_result Match::play(void)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    match_result result;
+    result.seed = config_.seed;
+    result.goals[0] = result.goals[1] = 0;
+    result.stuck_events[0] = result.stuck_events[1] = 0;
+    unsigned long possession_steps[2] = {0, 0};
+
+    const unsigned int n = behaviours_.size();
+    const int ball = world_.ball_index();
+    kick_off();
+    while(world_.sim_time() < config_.duration)
+    {
+        const bool control_tick = control_scheduler_.should_publish(world_.sim_time());
+        bool holding[2] = {false, false};
+        transform_ball_to_egos(world_.states(), ball, ball_relative_);
+        const int holder = possession_.update(ball_relative_);
+        for(unsigned int i=0; i<n; i++)
+        {
+            RobotBehaviour & behaviour = behaviours_[i];
+            behaviour.update(world_.states(), world_.iterations(), world_.sim_time(), i, ball, backends_[i]);
+            if(control_tick)
+                control(i);
+
+            const bool hold = holder == (int)i;
+            holding[(int)magenta_[i]] |= hold;
+            if(dribble_[i] && hold)
+                behaviour.dribble_ball(backends_[i]);
+
+            if(behaviour.stuck() && !was_stuck_[i])
+                result.stuck_events[(int)magenta_[i]]++;
+            was_stuck_[i] = behaviour.stuck();
+        }
+        possession_steps[0] += holding[0];
+        possession_steps[1] += holding[1];
+
+        world_.step();
+        if(world_.goal())
+        {
+            result.goals[world_.goal() > 0 ? 0 : 1]++;
+            kick_off();
+        }
+    }
+
+    const double steps = std::max(world_.iterations(), 1UL);
+    result.possession[0] = possession_steps[0] / steps;
+    result.possession[1] = possession_steps[1] / steps;
+    result.sim_time = world_.sim_time();
+    result.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
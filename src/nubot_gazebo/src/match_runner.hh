@@ -0,0 +1,87 @@
+#ifndef MATCH_RUNNER_HH
+#define MATCH_RUNNER_HH
+
+#include "kinematic_world.hh"
+#include "robot_behaviour.hh"
+#include "ball_possession.hh"
+#include "publish_scheduler.hh"
+
+#include <stdint.h>
+#include <random>
+#include <vector>
+
+namespace gazebo{
+   /// \brief Set-up of one match; the defaults are those of global_config.yaml
+   struct match_config
+   {
+       int          cyan_num;
+       int          magenta_num;
+       double       field_length;           // m
+       double       field_width;
+       double       step_size;              // simulated time per step (s)
+       double       duration;               // simulated time of the match (s)
+       double       ball_decay_coef;
+       double       dribble_distance_thres;
+       double       dribble_angle_thres;
+       double       possession_distance_margin;     // hysteresis of BallPossession (m)
+       double       possession_angle_margin;        // (degree)
+       double       noise_scale;
+       double       noise_rate;
+       double       stuck_window;
+       double       stuck_ratio;
+       double       start_jitter;           // start positions vary this much around the formation slots (m)
+       uint64_t     seed;                   // seeds the perception noise and the start positions
+
+       match_config()
+           : cyan_num(3), magenta_num(3), field_length(18.0), field_width(12.0), step_size(0.01),
+             duration(600.0), ball_decay_coef(0.5), dribble_distance_thres(0.50), dribble_angle_thres(30.0),
+             possession_distance_margin(0.05), possession_angle_margin(5.0), noise_scale(0.10), noise_rate(0.01), stuck_window(0.6), stuck_ratio(0.9), start_jitter(0.3), seed(1)
+       {}
+   };
+
+   /// \brief Outcome of one match; index 0 is cyan, 1 is magenta
+   struct match_result
+   {
+       uint64_t     seed;
+       int          goals[2];
+       double       possession[2];          // share of the match a robot of the team held the ball
+       int          stuck_events[2];        // times a robot of the team became stuck
+       double       sim_time;               // s
+       double       wall_time;              // s
+   };
+
+  /// \class Match
+  /// \brief One match in a KinematicWorld, in-process and without ROS. Every robot runs the policy
+  /// of strategy/strategy.py (chase the ball, dribble it towards the opponent goal) through the same
+  /// RobotBehaviour as NubotGazebo. Cyan attacks the goal at +x, magenta the one at -x; after a goal
+  /// all robots return to their start positions and the ball to the center.
+  class Match
+  {
+    public:
+        explicit Match(const match_config & config);
+
+        /// \brief Play the whole match
+        match_result play(void);
+
+    private:
+        /// \brief Robots to their start positions, ball to the center
+        void kick_off(void);
+
+        /// \brief strategy.py for one robot: velocity command and dribbling
+        void control(unsigned int robot);
+
+        match_config                    config_;
+        KinematicWorld                  world_;
+        std::vector<RobotBehaviour>     behaviours_;
+        std::vector<KinematicRobot>     backends_;
+        std::vector<double>             start_x_, start_y_;     // world frame
+        std::vector<char>               magenta_;
+        std::vector<char>               dribble_;               // BallHandle enabled and holding the ball
+        std::vector<char>               was_stuck_;
+        BallPossession                  possession_;            // who holds the ball, decided once per step
+        EgoStates                       ball_relative_;
+        PublishScheduler                control_scheduler_;     // strategy.py runs at 50 Hz
+  };
+}
+
+#endif //! MATCH_RUNNER_HH
@@ -0,0 +1,102 @@
+#include "model_registry.hh"
+
+#include <ros/ros.h>
+#include <cctype>
+#include <cstdlib>
+
+using namespace gazebo;
+
+ModelRegistry::ModelRegistry(const std::string & cyan_pre, const std::string & mag_pre, const std::string & ball_name)
+    : cyan_pre_(cyan_pre), mag_pre_(mag_pre), ball_name_(ball_name),
+      version_(0), ball_index_(-1)
+{
+    world_ids_.reserve(40);
+    records_.reserve(20);
+    models_.reserve(20);
+    names_.reserve(20);
+}
+
+bool ModelRegistry::parse(const std::string & name, model_record & record) const
+{
+    if(name == ball_name_)
+    {
+        record.kind     = BALL_MODEL;
+        record.team     = NO_TEAM;
+        record.agent_id = 0;
+        return true;
+    }
+
+    const std::string * prefix;
+    if(name.compare(0, cyan_pre_.size(), cyan_pre_) == 0)
+    {
+        prefix = &cyan_pre_;
+        record.team = CYAN_TEAM;
+    }
+    else if(name.compare(0, mag_pre_.size(), mag_pre_) == 0)
+    {
+        prefix = &mag_pre_;
+        record.team = MAGENTA_TEAM;
+    }
+    else
+        return false;
+
+    // the rest of the name must be the robot id, e.g. "nubot12"
+    for(unsigned int i=prefix->size(); i<name.size(); i++)
+        if(!isdigit(name[i]))
+            return false;
+
+    record.kind     = ROBOT_MODEL;
+    record.agent_id = atoi(name.c_str() + prefix->size());
+    return true;
+}
+
+int ModelRegistry::find(const std::string & name) const
+{
+    for(unsigned int i=0; i<names_.size(); i++)
+        if(names_[i] == name)
+            return i;
+    return -1;
+}
+
+bool ModelRegistry::update(physics::WorldPtr world)
+{
+    // a few dozen integer compares per step; the model count alone misses a removal and an
+    // insertion in the same step, e.g. a respawned robot
+    unsigned int count = world->GetModelCount();
+    bool changed = version_ == 0 || count != world_ids_.size();
+    for(unsigned int i=0; !changed && i<count; i++)
+    {
+        physics::ModelPtr model = world->GetModel(i);
+        changed = !model || model->GetId() != world_ids_[i];
+    }
+    if(!changed)
+        return false;
+
+    records_.clear();
+    models_.clear();
+    names_.clear();
+    ball_index_ = -1;
+
+    physics::Model_V models = world->GetModels();
+    model_record     record;
+    world_ids_.clear();
+    for(unsigned int i=0; i<models.size(); i++)
+    {
+        world_ids_.push_back(models[i]->GetId());
+        std::string name = models[i]->GetName();
+        if(!parse(name, record))
+            continue;
+
+        record.index = records_.size();
+        if(record.kind == BALL_MODEL)
+            ball_index_ = record.index;
+
+        records_.push_back(record);
+        models_.push_back(models[i]);
+        names_.push_back(name);
+    }
+
+    version_++;
+    ROS_INFO("ModelRegistry: tracking %d models (version %d)", (int)records_.size(), version_);
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef MODEL_REGISTRY_HH
+#define MODEL_REGISTRY_HH
+
+#include <gazebo/gazebo.hh>
+#include <gazebo/physics/physics.hh>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum model_kind
+{
+    ROBOT_MODEL,
+    BALL_MODEL
+};
+
+enum team_id
+{
+    NO_TEAM = -1,
+    CYAN_TEAM = 0,
+    MAGENTA_TEAM = 1
+};
+
+namespace gazebo{
+   /// \brief Role of a tracked model, worked out once from its name
+   struct model_record
+   {
+       model_kind  kind;
+       int         team;            // CYAN_TEAM or MAGENTA_TEAM; NO_TEAM for the football
+       int         agent_id;        // robot id parsed from the model name; 0 for the football
+       int         index;           // index in the registry, also the index in WorldSnapshot::models
+   };
+
+  /// \class ModelRegistry
+  /// \brief Maps the robots and the football in the world to integer records.
+  /// Model names are only parsed when models are added or removed, so the per-step
+  /// loops work on integers.
+  class ModelRegistry
+  {
+    public:
+        /// \param[in] cyan_pre     cyan robot model name prefix
+        /// \param[in] mag_pre      magenta robot model name prefix
+        /// \param[in] ball_name    football model name
+        ModelRegistry(const std::string & cyan_pre, const std::string & mag_pre, const std::string & ball_name);
+
+        /// \brief Rebuild the registry if models have been added to or removed from the world.
+        /// Compares the ids of all models of the world with those of the last rebuild, so a model
+        /// removed and another inserted in the same step is noticed as well.
+        /// \return true if the registry has been rebuilt
+        bool update(physics::WorldPtr world);
+
+        /// \brief Work out the role of a model from its name; "<prefix><id>" for robots,
+        /// where id may have any number of digits.
+        /// \param[in]  name    model name
+        /// \param[out] record  kind, team and agent_id of the model; index is not touched
+        /// \return false if the model is neither a robot nor the football
+        bool parse(const std::string & name, model_record & record) const;
+
+        /// \brief index of a model in the registry, -1 if it is not tracked
+        int find(const std::string & name) const;
+
+        const std::vector<model_record> &       records() const     { return records_; }
+        const std::vector<physics::ModelPtr> &  models() const      { return models_; }
+        const std::vector<std::string> &        names() const       { return names_; }
+        int                                     ball_index() const  { return ball_index_; }
+
+        /// \brief increased on every rebuild, so users can refresh cached indices
+        unsigned int                            version() const     { return version_; }
+
+    private:
+        std::vector<model_record>       records_;
+        std::vector<physics::ModelPtr>  models_;
+        std::vector<std::string>        names_;
+        std::string                     cyan_pre_;
+        std::string                     mag_pre_;
+        std::string                     ball_name_;
+        std::vector<uint32_t>           world_ids_;             // ids of all models of the world at the last rebuild
+        unsigned int                    version_;
+        int                             ball_index_;
+  };
+}
+
+#endif //! MODEL_REGISTRY_HH
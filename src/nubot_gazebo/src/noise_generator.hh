@@ -0,0 +1,80 @@
+#ifndef NOISE_GENERATOR_HH
+#define NOISE_GENERATOR_HH
+
+#include <cmath>
+#include <ctime>
+#include <stdint.h>
+
+namespace gazebo{
+  /// \class NoiseGenerator
+  /// \brief Counter-based perception noise. Sample j of step k of a stream is a pure function of
+  /// (seed, stream, k, j), so runs with the same seed get identical noise regardless of the order
+  /// in which plugins are updated or how often messages are published. No state is shared between
+  /// robots, and a whole snapshot is generated in one loop.
+  class NoiseGenerator
+  {
+    public:
+        NoiseGenerator() : key_(0) {}
+
+        /// \brief Select the random stream
+        /// \param[in] seed     base seed of the run; the same for all robots
+        /// \param[in] stream   stream of this robot, e.g. derived from its team and id
+        void seed(uint64_t seed, uint64_t stream)
+        {
+            key_ = mix(seed ^ mix(stream + 0x632be59bd9b4e019ULL));
+        }
+
+        /// \brief Fill a buffer with noise for one step. Each sample is 0 with probability
+        /// 1 - probability and scale * N(0,1) otherwise.
+        /// \param[in]  step        step counter, e.g. the world iteration
+        /// \param[in]  n           number of samples
+        /// \param[in]  scale       standard deviation of the noise
+        /// \param[in]  probability probability of a sample being noisy, in [0,1]
+        /// \param[out] out         n samples
+        void generate(uint64_t step, unsigned int n, double scale, double probability, double * out) const
+        {
+            if(scale == 0.0 || probability <= 0.0)
+            {
+                for(unsigned int j=0; j<n; j++)
+                    out[j] = 0.0;
+                return;
+            }
+            const uint64_t base = mix(key_ ^ mix(step));
+            const double gate = probability * 2097152.0;        // compared against 21 random bits
+            for(unsigned int j=0; j<n; j++)
+            {
+                const uint64_t h1 = mix(base + (2*(uint64_t)j + 1) * GOLDEN);
+                const uint64_t h2 = mix(base + (2*(uint64_t)j + 2) * GOLDEN);
+                const double u1 = ((h1 >> 11) + 1) * (1.0 / 9007199254740992.0);     // (0, 1]
+                const double u2 = (h2 >> 11) * (1.0 / 9007199254740992.0);           // [0, 1)
+                const double g  = (double)((h1 & 0x7ff) | ((h2 & 0x3ff) << 11));       // [0, 2^21)
+                // Box-Muller
+                const double normal = std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * M_PI * u2);
+                out[j] = g < gate ? scale * normal : 0.0;
+            }
+        }
+
+        /// \brief A seed for runs that don't configure one; drawn once per process, so all robots
+        /// of a run share it and it can be logged for replay
+        static uint64_t default_seed(void)
+        {
+            static const uint64_t seed = mix((uint64_t)std::time(NULL) ^ ((uint64_t)std::clock() << 32));
+            return seed;
+        }
+
+    private:
+        static const uint64_t GOLDEN = 0x9e3779b97f4a7c15ULL;
+
+        /// \brief splitmix64 finalizer
+        static uint64_t mix(uint64_t z)
+        {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        uint64_t    key_;
+  };
+}
+
+#endif //! NOISE_GENERATOR_HH
@@ -6,23 +6,17 @@
 #include <algorithm>
 #include <assert.h>
 #include <cmath>
+#include <limits>
 #include "nubot_gazebo.hh"
 #include "vector_angle.hh"
+#include "alloc_counter.hh"
 
-#define RUN 1
-#define FLY -1
 #define ZERO_VECTOR math::Vector3::Zero
 #define PI 3.14159265
 
 #define CM2M_CONVERSION 0.01
 #define M2CM_CONVERSION 100
 
-enum {NOTSEEBALL = 0, SEEBALLBYOWN = 1,SEEBALLBYOTHERS = 2};
-const math::Vector3 kick_vector_robot(1,0,0);    // assume the normalized vector from origin to kicking mechanism in robot refercence frame
-// is in x-axis direction
-const double goal_x = 9.0;
-const double goal_height = 1.0;
-const double        g = 9.8;
 const double        m = 0.41;                   // ball mass (kg)
 const double eps = 0.0001;                      // small value
 
@@ -32,53 +26,66 @@ GZ_REGISTER_MODEL_PLUGIN(NubotGazebo)
 NubotGazebo::NubotGazebo()
 {
     // Variables initialization
-    desired_rot_vector_ = ZERO_VECTOR;
-    desired_trans_vector_ = ZERO_VECTOR;
-    nubot_ball_vec_ = math::Vector3(1,0,0);
-    kick_vector_world_ = kick_vector_robot;
-    nubot_ball_vec_len_ = 1;
-    ball_index_=robot_index_=0;
+    ball_index_=0;
+    robot_index_=-1;
+    registry_version_=0;
+    my_team_ = CYAN_TEAM;
     Vx_cmd_=Vy_cmd_=w_cmd_=0;
     force_ = 0.0; mode_=1;
 
-    model_count_ = 0;
     dribble_flag_ = false;
     shot_flag_ = false;
-    ModelStatesCB_flag_ = false;
-    judge_nubot_stuck_ = false;
     is_kick_ = false;
     flip_cord_ = false;
+    world_state_ = NULL;
+    team_world_ = NULL;
+    sim_time_ = 0.0;
+    shoot_seq_ = 0;
+    srv_ball_cmd_.dribble = false;
+    srv_ball_cmd_.shoot = false;
+    srv_ball_cmd_.shoot_seq = 0;
+    srv_ball_cmd_.force = 0.0;
+    srv_ball_cmd_.mode = 1;
+    srv_ball_cmd_.seq = 0;
+    srv_ball_cmd_.shoot_done = false;
+    actuator_seq_ = 0;
+    shoot_done_ = false;
+    tick_count_ = 0;
+    is_stuck_ = is_hold_ball_ = false;
+    publish_allocations_ = steady_allocation_count_ = warm_tick_ = 0;
+    warm_version_ = 0;
     AgentID_ = 0;
     noise_scale_ = 0.0;
     noise_rate_ = 0.0;
+    noise_seed_ = 0;
+    noise_scale_param_ = noise_rate_param_ = NULL;
+    step_timer_ = NULL;
+    stats_ = NULL;
+    report_period_param_ = NULL;
+    last_report_ = 0.0;
+    traced_seq_ = 0;
+    latency_traced_ = false;
+    report_layout_ = 0;
+    set_vx_ = set_vy_ = set_w_ = 0.0;
+    lockstep_ = NULL;
+    hold_vel_cmd_ = false;
     state_ = CHASE_BALL;
     sub_state_ = MOVE_BALL;
-
-    obs_ = new Obstacles();
-    if(!obs_)
-        ROS_FATAL("Cannot allocate memory to type Obstacles!");
-
-    // Resize message fields
-    model_states_.name.reserve(20);
-    model_states_.pose.reserve(20);
-    model_states_.twist.reserve(20);
 }
 
 NubotGazebo::~NubotGazebo()
 {
+    if(lockstep_)
+        lockstep_->remove_robot(model_name_);
     event::Events::DisconnectWorldUpdateBegin(update_connection_);
-    // Removes all callbacks from the queue. Does not wait for calls currently in progress to finish.
-    message_queue_.clear();
-    service_queue_.clear();
-    // Disable the queue, meaning any calls to addCallback() will have no effect.
-    message_queue_.disable();
-    service_queue_.disable();
-    rosnode_->shutdown();                     // This MUST BE CALLED before thread join()!!
-    message_callback_queue_thread_.join();
-    service_callback_queue_thread_.join();
+    rosnode_->shutdown();                     // No more callbacks are added to the queues after this
+    // Removes all callbacks from the queues and waits for calls currently in progress to finish.
+    if(message_queue_)
+        message_queue_->disable();
+    if(service_queue_)
+        service_queue_->disable();
 
     delete rosnode_;
-    delete obs_;
 }
 
 void NubotGazebo::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
@@ -87,7 +94,6 @@ void NubotGazebo::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     world_ = _model->GetWorld();
     robot_model_ = _model;
     model_name_ = robot_model_->GetName();
-    robot_namespace_ = robot_model_->GetName();
 
     // Make sure the ROS node for Gazebo has already been initialized
     if (!ros::isInitialized())
@@ -96,17 +102,53 @@ void NubotGazebo::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
                          << "Load the Gazebo system plugin 'libnubot_gazebo.so' in the gazebo_ros package)");
         return;
     }
+    // the field this robot plays on: "field<K>_nubot1" plays on field K, "nubot1" on field 0
+    double field_spacing;
+    ros::param::param<double>("/fields/spacing",                field_spacing,              20.0);
+    field_ = parse_field(model_name_, field_spacing);
+    robot_namespace_ = field_.field > 0 ? field_.ns.substr(1) + "/" + field_.local_name : model_name_;
+
     rosnode_ = new ros::NodeHandle(robot_namespace_);
     rosnode_->param<std::string>("/football/name",                   ball_name_,             std::string("football") );
     rosnode_->param<std::string>("/football/chassis_link",           ball_chassis_,          std::string("football::ball") );
     rosnode_->param<std::string>("/cyan/prefix",                     cyan_pre_,              std::string("nubot"));
     rosnode_->param<std::string>("/magenta/prefix",                  mag_pre_,              std::string("rival"));
-    rosnode_->param<double>("/general/dribble_distance_thres",  dribble_distance_thres_,    0.50);
-    rosnode_->param<double>("/general/dribble_angle_thres",     dribble_angle_thres_,       30.0);
     rosnode_->param<double>("/field/length",                    field_length_,              18.0);
     rosnode_->param<double>("/field/width",                     field_width_,               12.0);
-    rosnode_->param<double>("/general/noise_scale",             noise_scale_,               0.10);
-    rosnode_->param<double>("/general/noise_rate",              noise_rate_,                0.01);
+
+    // every field has its own football and robots; /field<K>/field/length and width override the global size
+    ball_name_    = field_.prefix + ball_name_;
+    ball_chassis_ = field_.prefix + ball_chassis_;
+    cyan_pre_     = field_.prefix + cyan_pre_;
+    mag_pre_      = field_.prefix + mag_pre_;
+    if(field_.field > 0)
+    {
+        rosnode_->param<double>(field_.ns + "/field/length",    field_length_,              field_length_);
+        rosnode_->param<double>(field_.ns + "/field/width",     field_width_,               field_width_);
+    }
+
+    // tunable at run time through the shared parameter store; see param_store.hh
+    ParamStore* params = ParamStore::Instance();
+    noise_scale_param_      = params->declare("/general/noise_scale",             0.10);
+    noise_rate_param_       = params->declare("/general/noise_rate",              0.01);
+    get_params();
+    step_timer_ = StepTimer::Instance();
+    stats_ = PluginStats::Instance();
+    report_period_param_ = params->declare("/general/instrumentation_period", 5.0);
+
+    int noise_seed;
+    rosnode_->param<int>("/general/noise_seed",                 noise_seed,                 0);
+    bool lockstep;
+    rosnode_->param<bool>("/general/lockstep",                  lockstep,                   false);
+    double stuck_window, stuck_ratio;
+    rosnode_->param<double>("/general/stuck_window",            stuck_window,               0.6);
+    rosnode_->param<double>("/general/stuck_ratio",             stuck_ratio,                0.9);
+    int callback_threads;
+    rosnode_->param<int>("/general/callback_threads",           callback_threads,           2);
+    double omni_rate, omni_phase_step, omni_change_thres;
+    rosnode_->param<double>("/general/omni_vision_rate",        omni_rate,                  30.0);
+    rosnode_->param<double>("/general/omni_vision_phase_step",  omni_phase_step,            0.0);
+    rosnode_->param<double>("/general/omni_vision_change_thres",omni_change_thres,          0.0);
 
     if(!_sdf->HasElement("flip_cord"))
     {
@@ -116,8 +158,6 @@ void NubotGazebo::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
     else
         flip_cord_ = _sdf->GetElement("flip_cord")->Get<bool>();
 
-    AgentID_ = atoi( model_name_.substr(cyan_pre_.size(),1).c_str() );    // get the robot id
-
     // Load the football model
     ball_model_ = world_->GetModel(ball_name_);
     if (!ball_model_)
@@ -129,48 +169,108 @@ void NubotGazebo::Load(physics::ModelPtr _model, sdf::ElementPtr _sdf)
             ROS_ERROR("link [%s] does not exist!", ball_chassis_.c_str());
     }
 
+    // World state shared by all robots; filled once per physics step from physics::World
+    const std::string goal_names[2] = {field_.prefix + "left_goal", field_.prefix + "right_goal"};
+    world_state_ = WorldStateCache::Instance(world_, field_.field, field_.origin_x, field_.origin_y,
+                                             cyan_pre_, mag_pre_, ball_name_, goal_names);
+
+    model_record my_record;
+    if(world_state_->parse(model_name_, my_record) && my_record.kind == ROBOT_MODEL)
+        AgentID_ = my_record.agent_id;                                     // get the robot id
+    else
+        ROS_ERROR("%s is not a valid robot name. Use %s<id> or %s<id>",
+                  model_name_.c_str(), cyan_pre_.c_str(), mag_pre_.c_str());
+    my_team_ = flip_cord_ ? MAGENTA_TEAM : CYAN_TEAM;
+
+    // one noise stream per robot and field, so the matches of different fields are independent;
+    // with the same seed a run gets the same noise again. Field 0 keeps team * 1000 + id.
+    noise_seed_ = noise_seed != 0 ? (uint64_t)(unsigned int)noise_seed : NoiseGenerator::default_seed();
+
+    // enough stuck samples to cover the stuck window at the physics rate
+    double step_size = world_->GetPhysicsEngine()->GetMaxStepSize();
+    behaviour_.configure(flip_cord_, noise_seed_, (field_.field * 2 + my_team_) * 1000 + AgentID_,
+                         stuck_window, (unsigned int)ceil(stuck_window / std::max(step_size, 1e-4)) + 2, stuck_ratio);
+
+    // robots publish in different steps if a phase step is given; one slot per robot of both teams
+    int cyan_num;
+    rosnode_->param<int>("/cyan/num",                           cyan_num,                   3);
+    const int publish_slot = my_team_ * cyan_num + AgentID_ - 1;
+    omni_scheduler_.configure(omni_rate, omni_phase_step * publish_slot, omni_change_thres);
+
+    // one WorldModelInfo per team, published by whichever robot of the team is updated first
+    team_world_ = TeamWorldPublisher::Instance(field_.field, field_.ns, my_team_, omni_rate);
+
+    // Callback queues of this robot, served by worker threads shared by all robots
+    CallbackExecutor* executor = CallbackExecutor::Instance(callback_threads);
+    message_queue_ = executor->create_queue();
+    service_queue_ = executor->create_queue();
+
     // Publishers
     omin_vision_pub_   = rosnode_->advertise<nubot_common::OminiVisionInfo>("omnivision/OmniVisionInfo",10);
+    odo_info_pub_      = rosnode_->advertise<nubot_common::OdoInfo>("nubotdriver/odoinfo",10);
     debug_pub_ = rosnode_->advertise<std_msgs::Float64MultiArray>("debug",10);
 
     // Subscribers.
-    ros::SubscribeOptions so1 = ros::SubscribeOptions::create<gazebo_msgs::ModelStates>(
-                "/gazebo/model_states", 100, boost::bind( &NubotGazebo::model_states_CB,this,_1),
-                ros::VoidPtr(), &message_queue_);
-    ModelStates_sub_ = rosnode_->subscribe(so1);
-
     ros::SubscribeOptions so2 = ros::SubscribeOptions::create<nubot_common::VelCmd>(
                 "nubotcontrol/velcmd", 100, boost::bind( &NubotGazebo::vel_cmd_CB,this,_1),
-                ros::VoidPtr(), &message_queue_);
+                ros::VoidPtr(), message_queue_.get());
     Velcmd_sub_ = rosnode_->subscribe(so2);
 
+    ros::SubscribeOptions so3 = ros::SubscribeOptions::create<nubot_common::VelCmdStamped>(
+                "nubotcontrol/velcmd_stamped", 100, boost::bind( &NubotGazebo::vel_cmd_stamped_CB,this,_1),
+                ros::VoidPtr(), message_queue_.get());
+    velcmd_stamped_sub_ = rosnode_->subscribe(so3);
+
+    ros::SubscribeOptions so4 = ros::SubscribeOptions::create<nubot_common::ActuatorCmd>(
+                "nubotcontrol/actuator", 100, boost::bind( &NubotGazebo::actuator_CB,this,_1),
+                ros::VoidPtr(), message_queue_.get());
+    actuator_sub_ = rosnode_->subscribe(so4);
+    ros::SubscribeOptions so5 = ros::SubscribeOptions::create<nubot_common::TeamActuatorCmd>(
+                field_.ns + (my_team_ == CYAN_TEAM ? "/cyan" : "/magenta") + "/teamcontrol/actuator", 10,
+                boost::bind( &NubotGazebo::team_actuator_CB,this,_1), ros::VoidPtr(), message_queue_.get());
+    team_actuator_sub_ = rosnode_->subscribe(so5);
+    actuator_state_pub_ = rosnode_->advertise<nubot_common::ActuatorState>("nubotcontrol/actuator_state", 10);
+    diagnostics_pub_ = rosnode_->advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+    robot_report_.status.reserve(2);
+    publish_status_.name = "nubot_gazebo: " + model_name_ + " publishing";
+    publish_status_.hardware_id = "gzserver";
+    latency_status_.name = "nubot_gazebo: " + model_name_ + " command latency";
+    latency_status_.hardware_id = "gzserver";
+
     // Service Servers
     ros::AdvertiseServiceOptions aso1 = ros::AdvertiseServiceOptions::create<nubot_common::BallHandle>(
                 "BallHandle", boost::bind(&NubotGazebo::ball_handle_control_service, this, _1, _2),
-                ros::VoidPtr(), &service_queue_);
+                ros::VoidPtr(), service_queue_.get());
     ballhandle_server_ =   rosnode_->advertiseService(aso1);
 
     ros::AdvertiseServiceOptions aso2 = ros::AdvertiseServiceOptions::create<nubot_common::Shoot>(
                 "Shoot", boost::bind(&NubotGazebo::shoot_control_servive, this, _1, _2),
-                ros::VoidPtr(), &service_queue_);
+                ros::VoidPtr(), service_queue_.get());
     shoot_server_ =   rosnode_->advertiseService(aso2);
 
+    // Lockstep mode: an external client steps the world; see LockstepServer
+    if(lockstep)
+    {
+        lockstep_ = LockstepServer::Instance(world_);
+        lockstep_->add_robot(model_name_, this);
+    }
+
 #if 0
     reconfigureServer_ = new dynamic_reconfigure::Server<nubot_gazebo::NubotGazeboConfig>(*rosnode_);
     reconfigureServer_->setCallback(boost::bind(&NubotGazebo::config, this, _1, _2));
 #endif
 
-    // Custom Callback Queue Thread. Use threads to process message and service callback queue
-    message_callback_queue_thread_ = boost::thread( boost::bind( &NubotGazebo::message_queue_thread,this ) );
-    service_callback_queue_thread_ = boost::thread( boost::bind( &NubotGazebo::service_queue_thread,this ) );
-
     // This event is broadcast every simulation iteration.
     update_connection_ = event::Events::ConnectWorldUpdateBegin(
                 boost::bind(&NubotGazebo::update_child, this));
 
     // Output info
-    ROS_INFO(" %s has %d plugins\n\tid: %d \tflip_cord:%d\n\tgaussian_noise -- scale: %f\t rate: %f",
-              model_name_.c_str(), robot_model_->GetPluginCount(), AgentID_, flip_cord_, noise_scale_, noise_rate_);
+    ROS_INFO(" %s has %d plugins\n\tid: %d \tflip_cord:%d\n\tgaussian_noise -- scale: %f\t rate: %f\t seed: %llu",
+              model_name_.c_str(), robot_model_->GetPluginCount(), AgentID_, flip_cord_, noise_scale_, noise_rate_,
+              (unsigned long long)noise_seed_);
+    if(noise_seed == 0)
+        ROS_INFO(" %s: noise seed drawn at random; set /general/noise_seed to replay this run's noise",
+                 model_name_.c_str());
 
 }
 
@@ -179,43 +279,19 @@ void NubotGazebo::Reset()
     ROS_DEBUG("%s Reset() running now!", model_name_.c_str());
 
     // Variables initialization
-    desired_rot_vector_ = ZERO_VECTOR;
-    desired_trans_vector_ = ZERO_VECTOR;
-    nubot_ball_vec_ = math::Vector3(1,0,0);
-    kick_vector_world_ = kick_vector_robot;
-    nubot_ball_vec_len_ = 1;
     Vx_cmd_=Vy_cmd_=w_cmd_=0;
     force_ = 0.0; mode_=1;
 
     dribble_flag_ = false;
     shot_flag_ = false;
-    ModelStatesCB_flag_ = false;
-    judge_nubot_stuck_ = false;
+    behaviour_.reset();
+    is_stuck_ = is_hold_ball_ = false;
     is_kick_ = false;
     state_ = CHASE_BALL;
     sub_state_ = MOVE_BALL;
 
 }
 
-void NubotGazebo::message_queue_thread()
-{
-    static const double timeout = 0.01;
-    while (rosnode_->ok())
-    {
-        // Invoke all callbacks currently in the queue. If a callback was not ready to be called,
-        // pushes it back onto the queue. This version includes a timeout which lets you specify
-        // the amount of time to wait for a callback to be available before returning.
-        message_queue_.callAvailable(ros::WallDuration(timeout));
-    }
-}
-
-void NubotGazebo::service_queue_thread()
-{
-    static const double timeout = 0.01;
-    while (rosnode_->ok())
-        service_queue_.callAvailable(ros::WallDuration(timeout));
-}
-
 void NubotGazebo::config(nubot_gazebo::NubotGazeboConfig &config, uint32_t level)
 {
     dribble_P_      = config.P;
@@ -227,533 +303,469 @@ void NubotGazebo::config(nubot_gazebo::NubotGazeboConfig &config, uint32_t level
               dribble_P_, dribble_I_, dribble_D_, I_term_max_, I_term_min_);
 }
 
-void NubotGazebo::model_states_CB(const gazebo_msgs::ModelStates::ConstPtr& _msg)
+bool NubotGazebo::update_model_info(const WorldSnapshot & snapshot)
 {
-    msgCB_lock_.lock();
-
-    ModelStatesCB_flag_ = true;
-    model_count_ = 0;
-    model_states_.name.clear();
-    model_states_.pose.clear();
-    model_states_.twist.clear();
-
-    for(int i=0; i<world_->GetModelCount() ;i++)
+    // find myself in the snapshot; only needed when models have been added or removed
+    if(snapshot.version != registry_version_)
     {
-        // get info of robots and the ball; reference frame: world
-        if( (_msg->name[i].find(cyan_pre_) != std::string::npos) ||
-            (_msg->name[i].find(mag_pre_) != std::string::npos) ||
-            (_msg->name[i] == ball_name_) )
-        {
-            geometry_msgs::Pose     ps = _msg->pose[i];
-            geometry_msgs::Twist    tw = _msg->twist[i];
-            ps.position.x += noise(noise_scale_, noise_rate_);  // add gaussian noise
-            ps.position.y += noise(noise_scale_, noise_rate_);
-            // ps.position.z += noise(noise_scale_, noise_rate_);
-            tw.linear.x   += noise(noise_scale_, noise_rate_);
-            tw.linear.y   += noise(noise_scale_, noise_rate_);
-            // tw.linear.z   += noise(noise_scale_, noise_rate_);
-
-            if(flip_cord_)      // rival robot model
+        registry_version_ = snapshot.version;
+        robot_index_ = -1;
+        const std::vector<std::string> & names = *snapshot.names;
+        for(unsigned int i=0; i<names.size(); i++)
+            if(names[i] == model_name_)
             {
-                // We only have to change the sign of x and y positions, and x and y velocities;
-                // Since the coordinate frame of the rival model has been flipped, we don't have
-                // to change the orientation here.
-                ps.position.x *= -1.0;
-                ps.position.y *= -1.0;
-                tw.linear.x *= -1.0;
-                tw.linear.y *= -1.0;
+                robot_index_ = i;
+                break;
             }
 
-            model_states_.name.push_back(_msg->name[i]);
-            model_states_.pose.push_back(ps);
-            model_states_.twist.push_back(tw);
-
-            if(model_states_.name.back() == ball_name_ )
-                ball_index_ =  model_count_;
-            else if(model_states_.name.back() == model_name_)
-                robot_index_ = model_count_;
-
-            model_count_ ++;
-        }
+        // message buffers have a fixed size until models are added or removed
+        obstacles_.clear();
+        const std::vector<model_record> & records = *snapshot.records;
+        for(unsigned int i=0; i<records.size(); i++)
+            if(records[i].kind == ROBOT_MODEL && (int)i != robot_index_)
+                obstacles_.push_back(i);
+        omni_info_.obstacleinfo.pos.resize(obstacles_.size());
+        omni_info_.obstacleinfo.polar_pos.resize(obstacles_.size());
+        omni_info_.robotinfo.resize(robot_index_ >= 0 ? 1 : 0);
+        last_published_.resize(0);
+
+        // the goals are looked up together with the models
+        const goal_positions & goals = snapshot.goals;
+        if(goals.known)
+            behaviour_.set_goals(goals.left_x, goals.left_y, goals.right_x, goals.right_y);
     }
 
-    msgCB_lock_.unlock();
-}
-
-bool NubotGazebo::update_model_info(void)
-{
-    if(ModelStatesCB_flag_)
-    {
-        // Get football and nubot's pose and twist
-        ball_state_.model_name = ball_name_ ;
-        ball_state_.pose.position.x     = model_states_.pose[ball_index_].position.x;
-        ball_state_.pose.position.y     = model_states_.pose[ball_index_].position.y;
-        ball_state_.pose.position.z     = model_states_.pose[ball_index_].position.z;
-        ball_state_.pose.orient.w  = model_states_.pose[ball_index_].orientation.w;
-        ball_state_.pose.orient.x  = model_states_.pose[ball_index_].orientation.x;
-        ball_state_.pose.orient.y  = model_states_.pose[ball_index_].orientation.y;
-        ball_state_.pose.orient.z  = model_states_.pose[ball_index_].orientation.z;
-        ball_state_.twist.linear.x      = model_states_.twist[ball_index_].linear.x;
-        ball_state_.twist.linear.y      = model_states_.twist[ball_index_].linear.y;
-        ball_state_.twist.linear.z      = model_states_.twist[ball_index_].linear.z;
-        ball_state_.twist.angular.x     = model_states_.twist[ball_index_].angular.x;
-        ball_state_.twist.angular.y     = model_states_.twist[ball_index_].angular.y;
-        ball_state_.twist.angular.z     = model_states_.twist[ball_index_].angular.z;
-
-        robot_state_.model_name = ball_name_ ;
-        robot_state_.pose.position.x    = model_states_.pose[robot_index_].position.x;
-        robot_state_.pose.position.y    = model_states_.pose[robot_index_].position.y;
-        robot_state_.pose.position.z    = model_states_.pose[robot_index_].position.z;
-        robot_state_.pose.orient.w = model_states_.pose[robot_index_].orientation.w;
-        robot_state_.pose.orient.x = model_states_.pose[robot_index_].orientation.x;
-        robot_state_.pose.orient.y = model_states_.pose[robot_index_].orientation.y;
-        robot_state_.pose.orient.z = model_states_.pose[robot_index_].orientation.z;
-        robot_state_.twist.linear.x     = model_states_.twist[robot_index_].linear.x;
-        robot_state_.twist.linear.y     = model_states_.twist[robot_index_].linear.y;
-        robot_state_.twist.linear.z     = model_states_.twist[robot_index_].linear.z;
-        robot_state_.twist.angular.x    = model_states_.twist[robot_index_].angular.x;
-        robot_state_.twist.angular.y    = model_states_.twist[robot_index_].angular.y;
-        robot_state_.twist.angular.z    = model_states_.twist[robot_index_].angular.z;
-
-        // calculate vector from nubot to football
-        nubot_ball_vec_ = ball_state_.pose.position - robot_state_.pose.position;
-        nubot_ball_vec_len_ = nubot_ball_vec_.GetLength();
-
-        // transform kick_vector_nubot in world frame
-        math::Quaternion    rotation_quaternion = robot_state_.pose.orient;
-        math::Matrix3       RotationMatrix3 = rotation_quaternion.GetAsMatrix3();
-        kick_vector_world_ = RotationMatrix3 * kick_vector_robot; // vector from nubot origin to kicking mechanism in world frame
-        // ROS_INFO("kick_vector_world_: %f %f %f",kick_vector_world_.x, kick_vector_world_.y, kick_vector_world_.z);
-
-        obs_->world_obs_.reserve(20);
-        obs_->real_obs_.reserve(20);
-        obs_->world_obs_.clear();
-        obs_->real_obs_.clear();
-        omni_info_.robotinfo.reserve(10);
-        omni_info_.robotinfo.clear();
-        for(int i=0; i<model_count_;i++)
-        {
-            // Obstacles info (including teamates and opponent robots)
-            if(model_states_.name[i].compare(0, cyan_pre_.size(), cyan_pre_) == 0 ||
-               model_states_.name[i].compare(0, mag_pre_.size(), mag_pre_) == 0)   //compare model name' prefix to determine robots
-            {
-                math::Vector3 obs_pos(model_states_.pose[i].position.x,
-                                                model_states_.pose[i].position.y,
-                                                model_states_.pose[i].position.z);
-                if(i != robot_index_)
-                {
-                    obs_->world_obs_.push_back(nubot::DPoint(obs_pos.x, obs_pos.y));
-
-                    math::Vector3 nubot_obs_vec = obs_pos - robot_state_.pose.position;   // vector from nubot to obstacle
-                    obs_->real_obs_.push_back( nubot::PPoint( get_angle_PI(kick_vector_world_,nubot_obs_vec),nubot_obs_vec.GetLength()) );
-                }
-            }
-
-            // Teammates info (including myself)
-            std::string team_pre = flip_cord_? mag_pre_ : cyan_pre_;
-            if(model_states_.name[i].compare(0, team_pre.size(), team_pre) == 0)
-            {
-                int robot_id = atoi( model_states_.name[i].substr(team_pre.size(),1).c_str() );
-
-                // get my own and teammates's info
-                geometry_msgs::Pose  robot_pose = model_states_.pose[i];
-                geometry_msgs::Twist robot_twist = model_states_.twist[i];
-                math::Quaternion rot_qua(robot_pose.orientation.w, robot_pose.orientation.x,
-                                         robot_pose.orientation.y, robot_pose.orientation.z);
-                double heading_theta = rot_qua.GetYaw();
-                teamate_info_.header.seq++;
-                teamate_info_.header.stamp = ros::Time::now();
-                teamate_info_.AgentID       = robot_id;
-                teamate_info_.pos.x         = robot_pose.position.x * M2CM_CONVERSION;
-                teamate_info_.pos.y         = robot_pose.position.y * M2CM_CONVERSION;
-                teamate_info_.heading.theta = heading_theta;
-                teamate_info_.vrot          = robot_twist.angular.z;
-                teamate_info_.vtrans.x      = robot_twist.linear.x * M2CM_CONVERSION;
-                //teamate_info_.isvalid       = true;
-                teamate_info_.isvalid       =  is_robot_valid(robot_pose.position.x, robot_pose.position.y);
-                teamate_info_.vtrans.y      = robot_twist.linear.y * M2CM_CONVERSION;
-                teamate_info_.isstuck       = get_nubot_stuck();
-                omni_info_.robotinfo.push_back(teamate_info_);
-            }
-        }
+    if(snapshot.ball_index >= 0 && robot_index_ >= 0)
+    {
+        ball_index_  = snapshot.ball_index;
+        sim_time_    = snapshot.sim_time.Double();
+
+        // perception and stuck detection run once per step; the stuck flag is shared with the team's world model
+        behaviour_.update(snapshot.states, snapshot.iteration, sim_time_, robot_index_, ball_index_, *this);
+        if(latency_traced_)
+            latency_.observe(ros::WallTime::now().toSec(), sim_time_, snapshot.states.vx[robot_index_],
+                             snapshot.states.vy[robot_index_], snapshot.states.w[robot_index_]);
+        is_stuck_ = behaviour_.stuck();
+        is_hold_ball_ = snapshot.ball_holder == robot_index_;
+        world_state_->set_stuck(robot_index_, is_stuck_);
         return 1;
     }
     else
     {
-        ROS_INFO("%s update_model_info(): Waiting for model_states messages!", model_name_.c_str());
+        ROS_INFO("%s update_model_info(): Waiting for %s and %s to be spawned!",
+                 model_name_.c_str(), model_name_.c_str(), ball_name_.c_str());
         return 0;
     }
 }
 
-double NubotGazebo::noise(double scale, double probability)
+void NubotGazebo::fill_omni_info(void)
 {
-    if(math::equal<double>(scale, 0.0))
-        return 0.0;
-    else
-    {
-        if(rand_.GetIntUniform(0,10) <= (int)10.0*probability)
-            return scale*rand_.GetDblNormal(0,1);
-        else
-            return 0.0;
-    }
+    // The messages are filled in place; their arrays are sized in update_model_info() when
+    // models are added or removed, so no memory is allocated here in the steady state.
+    const PlanarStates & perceived = behaviour_.perceived();
+    robot_message_state state;
+    state.agent_id  = AgentID_;
+    state.valid     = is_robot_valid(perceived.x[robot_index_], perceived.y[robot_index_]);
+    state.hold_ball = is_hold_ball_;
+    fill_robot_messages(behaviour_, obstacles_, state, ros::Time::now(), omni_info_, odo_info_);
 }
 
 void NubotGazebo::message_publish(void)
 {
-    //ros::Time simulation_time(receive_sim_time_.sec, receive_sim_time_.nsec);
-    //math::Quaternion    rotation_quaternion=nubot_state_.pose.orientation;
-
-    ////////////// OminiVision message /////////////////////////
-    // ROS_INFO("Gazebo is publishing Omnivision Info!");
-    ball_info_.header.stamp = ros::Time::now();
-    ball_info_.header.seq++;
-    ball_info_.ballinfostate = SEEBALLBYOWN;
-    ball_info_.pos.x =  ball_state_.pose.position.x * M2CM_CONVERSION;
-    ball_info_.pos.y =  ball_state_.pose.position.y * M2CM_CONVERSION;
-    ball_info_.real_pos.angle  = get_angle_PI(kick_vector_world_,nubot_ball_vec_);
-    ball_info_.real_pos.radius = nubot_ball_vec_len_ * M2CM_CONVERSION;
-    ball_info_.velocity.x = ball_state_.twist.linear.x * M2CM_CONVERSION;
-    ball_info_.velocity.y = ball_state_.twist.linear.y * M2CM_CONVERSION;
-    ball_info_.pos_known = true;
-    ball_info_.velocity_known = true;
-
-    obstacles_info_.header.stamp = ros::Time::now();
-    obstacles_info_.header.seq++;
-    obstacles_info_.pos.clear();
-    obstacles_info_.polar_pos.clear();
-    int length= obs_->real_obs_.size();
-
-    nubot_common::Point2d point;                                    // message type in ObstaclesInfo.msg
-    nubot_common::PPoint  polar_point;                              // message type in ObstaclesInfo.msg
-    for(int i = 0 ; i < length ; i++)
-    {
-        nubot::DPoint & pt=obs_->world_obs_[i];         // DPoint is a type in nubot/core/core.hpp
-        nubot::PPoint & polar_pt= obs_->real_obs_[i];   // PPoint is a type in nubot/core/core.hpp
-
-        point.x=pt.x_ * M2CM_CONVERSION ;                           // Get the location info and put it in message type
-        point.y=pt.y_ * M2CM_CONVERSION;
-        polar_point.angle=polar_pt.angle_.radian_;
-        polar_point.radius=polar_pt.radius_;
-
-        obstacles_info_.pos.push_back(point);
-        obstacles_info_.polar_pos.push_back(polar_point);
-    }
-    omni_info_.header.stamp = ros::Time::now();
-    omni_info_.header.seq++;
-    omni_info_.ballinfo=ball_info_;
-    omni_info_.obstacleinfo=obstacles_info_;
+    fill_omni_info();
+
+    // roscpp serializes the message into a buffer of its own; not counted as our allocation
+    unsigned long allocations = allocation_count();
     omin_vision_pub_.publish(omni_info_);
+    odo_info_pub_.publish(odo_info_);
+    publish_allocations_ += allocation_count() - allocations;
+    stats_->count(COUNT_OMNI_VISION);
+}
 
+void NubotGazebo::vel_cmd_CB(const nubot_common::VelCmd::ConstPtr& cmd)
+{
+    PluginStats::Scope lock_wait(stats_, STAT_CMD_LOCK_WAIT);
+    boost::mutex::scoped_lock lock(cmd_lock_);
+    lock_wait.stop();
+    stats_->count(COUNT_VEL_CMD);
+    write_vel_cmd(*cmd);
 }
 
-void NubotGazebo::nubot_locomotion(math::Vector3 linear_vel_vector, math::Vector3 angular_vel_vector)
+void NubotGazebo::vel_cmd_stamped_CB(const nubot_common::VelCmdStamped::ConstPtr& cmd)
 {
-    desired_trans_vector_ = linear_vel_vector;
-    desired_rot_vector_   = angular_vel_vector;
-    // planar movement
-    desired_trans_vector_.z = 0;
-    desired_rot_vector_.x = 0;
-    desired_rot_vector_.y = 0;
-    robot_model_->SetLinearVel(desired_trans_vector_);
-    robot_model_->SetAngularVel(desired_rot_vector_);
-    judge_nubot_stuck_ = 1;                                                 // only afetr nubot tends to move can I judge if it is stuck
+    double received = ros::WallTime::now().toSec();
+    PluginStats::Scope lock_wait(stats_, STAT_CMD_LOCK_WAIT);
+    boost::mutex::scoped_lock lock(cmd_lock_);
+    lock_wait.stop();
+    stats_->count(COUNT_VEL_CMD);
+    write_vel_cmd(cmd->vel, &cmd->header, received);
 }
 
-void NubotGazebo::vel_cmd_CB(const nubot_common::VelCmd::ConstPtr& cmd)
+void NubotGazebo::actuator_CB(const nubot_common::ActuatorCmd::ConstPtr& cmd)
+{
+    PluginStats::Scope lock_wait(stats_, STAT_CMD_LOCK_WAIT);
+    boost::mutex::scoped_lock lock(cmd_lock_);
+    lock_wait.stop();
+    stats_->count(COUNT_VEL_CMD);
+    write_actuator_cmd(*cmd);
+}
+
+void NubotGazebo::team_actuator_CB(const nubot_common::TeamActuatorCmd::ConstPtr& cmds)
 {
-    msgCB_lock_.lock();
+    for(unsigned int i=0; i<cmds->commands.size(); i++)
+        if(cmds->commands[i].robot == field_.local_name)
+        {
+            PluginStats::Scope lock_wait(stats_, STAT_CMD_LOCK_WAIT);
+            boost::mutex::scoped_lock lock(cmd_lock_);
+            lock_wait.stop();
+            stats_->count(COUNT_VEL_CMD);
+            write_actuator_cmd(cmds->commands[i]);
+            return;
+        }
+}
+
+void NubotGazebo::write_actuator_cmd(const nubot_common::ActuatorCmd & cmd)
+{
+    write_vel_cmd(cmd.vel);
+
+    // both requests are decided on the same ball holding state, as one BallHandle and one Shoot call
+    ball_status_buf_.update();
+    bool is_hold_ball = ball_status_buf_.read_buffer().is_hold_ball;
+    request_dribble(cmd.dribble, is_hold_ball);
+    if(cmd.shoot)
+        request_shoot(cmd.strength, (int)cmd.ShootPos, is_hold_ball);
+    srv_ball_cmd_.seq = cmd.seq;
+    ball_cmd_buf_.write_buffer() = srv_ball_cmd_;
+    ball_cmd_buf_.publish();
+}
 
+void NubotGazebo::write_vel_cmd(const nubot_common::VelCmd & cmd, const std_msgs::Header * stamp, double received)
+{
+    // Only hand the command over; it is applied by the physics thread in update_child()
+    vel_cmd & next = vel_cmd_buf_.write_buffer();
     if(flip_cord_)
     {
-        Vx_cmd_ = -cmd->Vx * CM2M_CONVERSION;
-        Vy_cmd_ = -cmd->Vy * CM2M_CONVERSION;
+        next.Vx = -cmd.Vx * CM2M_CONVERSION;
+        next.Vy = -cmd.Vy * CM2M_CONVERSION;
     }
     else
     {
-        Vx_cmd_ = cmd->Vx * CM2M_CONVERSION;
-        Vy_cmd_ = cmd->Vy * CM2M_CONVERSION;
+        next.Vx = cmd.Vx * CM2M_CONVERSION;
+        next.Vy = cmd.Vy * CM2M_CONVERSION;
     }
-    w_cmd_  = cmd->w;
-    math::Vector3 Vx_nubot = Vx_cmd_ * kick_vector_world_;
-    math::Vector3 Vy_nubot = Vy_cmd_ * (math::Vector3(0,0,1).Cross(kick_vector_world_));    // velocity with reference to nubot
-    math::Vector3 linear_vector = Vx_nubot + Vy_nubot;
-    math::Vector3 angular_vector(0,0,w_cmd_);
+    next.w = cmd.w;
+    next.stamped  = stamp != NULL;
+    next.seq      = stamp ? stamp->seq : 0;
+    next.sent     = stamp ? stamp->stamp.toSec() : 0.0;
+    next.received = received;
+    vel_cmd_buf_.publish();
+}
 
-    //    ROS_FATAL("%s vel_cmd_CB():linear_vector:%f %f %f angular_vector:0 0 %f",model_name_.c_str(),
-    //                    linear_vector.x, linear_vector.y, linear_vector.z, angular_vector.z);
-    nubot_locomotion(linear_vector, angular_vector);
+void NubotGazebo::lockstep_command(const nubot_common::ActuatorCmd & cmd)
+{
+    {
+        boost::mutex::scoped_lock lock(cmd_lock_);
+        write_vel_cmd(cmd.vel);
+    }
+    hold_vel_cmd_ = true;           // the command holds for all steps of the request
+
+    nubot_common::BallHandle::Request  ball_handle_req;
+    nubot_common::BallHandle::Response ball_handle_res;
+    ball_handle_req.enable = cmd.dribble;
+    ball_handle_control_service(ball_handle_req, ball_handle_res);
 
-    msgCB_lock_.unlock();
+    if(cmd.shoot)
+    {
+        nubot_common::Shoot::Request  shoot_req;
+        nubot_common::Shoot::Response shoot_res;
+        shoot_req.strength = cmd.strength;
+        shoot_req.ShootPos = cmd.ShootPos;
+        shoot_control_servive(shoot_req, shoot_res);
+    }
 }
 
-bool NubotGazebo::ball_handle_control_service(nubot_common::BallHandle::Request  &req,
-                                              nubot_common::BallHandle::Response &res)
+void NubotGazebo::lockstep_state(nubot_common::OminiVisionInfo & info, bool & is_hold_ball)
 {
-    srvCB_lock_.lock();
+    // the world is paused, so the physics thread does not touch these members now
+    if(robot_index_ < 0 || ball_index_ >= (int)behaviour_.ego().size())       // not updated yet
+    {
+        is_hold_ball = false;
+        return;
+    }
+    fill_omni_info();
+    info = omni_info_;
+    is_hold_ball = is_hold_ball_;
+}
+
+void NubotGazebo::apply_vel_cmd(const vel_cmd & cmd)
+{
+    Vx_cmd_ = cmd.Vx;
+    Vy_cmd_ = cmd.Vy;
+    w_cmd_  = cmd.w;
+    behaviour_.move(Vx_cmd_, Vy_cmd_, w_cmd_, *this);
 
-    dribble_flag_ = req.enable ? 1 : 0;         // FIXME. when robot is stucked, req.enable=2
-    if(dribble_flag_)
+    // the first step a stamped command is applied in; in lockstep mode it is applied again every step
+    if(cmd.stamped && (cmd.seq != traced_seq_ || !latency_traced_))
     {
-        if(!get_is_hold_ball())     // when dribble_flag is true, it does not necessarily mean that I can dribble it now.
-        {                           // it just means the dribble ball mechanism is working.
-            dribble_flag_ = false;
-            res.BallIsHolding = false;
-            //ROS_INFO("%s dribble_service: Cannot dribble ball. angle error:%f distance error: %f",
-            //                              model_name_.c_str(), angle_error_degree_, nubot_football_vector_length_);
-        }
-        else
-        {
-            //ROS_INFO("%s dribble_service: dribbling ball now", model_name_.c_str());
-            dribble_flag_  = true;
-            res.BallIsHolding = true;
-        }
+        traced_seq_ = cmd.seq;
+        latency_traced_ = true;
+        latency_.applied(cmd.seq, cmd.sent, cmd.received, ros::WallTime::now().toSec(), sim_time_,
+                         set_vx_, set_vy_, set_w_);
     }
-    else
+}
+
+void NubotGazebo::report_diagnostics(void)
+{
+    const bool instrumented = stats_->enabled();
+    if(!instrumented && !latency_traced_)
+        return;
+    double now = ros::WallTime::now().toSec();
+    if(now - last_report_ < report_period_param_->get())
+        return;
+    last_report_ = now;
+
+    if(instrumented)
     {
-        res.BallIsHolding = get_is_hold_ball();
+        publish_status_.message = "OmniVisionInfo";
+        publish_status_.values.resize(2);
+        set_diagnostic_value(publish_status_, 0, "achieved rate (Hz)", omni_scheduler_.achieved_rate());
+        set_diagnostic_value(publish_status_, 1, "messages", omni_scheduler_.publish_count());
     }
+    const bool latency = latency_traced_ && latency_.report(latency_status_);
+    if(!instrumented && !latency)
+        return;
 
-    // ROS_FATAL("%s dribble:[enable holding]:[%d %d]",model_name_.c_str(), (int)req.enable, (int)res.BallIsHolding);
-    srvCB_lock_.unlock();
-    return true;
+    // the statuses are copied over those of the last report, reusing their strings; only a change
+    // of what is reported resizes the report, after which the step warms up again
+    std::vector<diagnostic_msgs::DiagnosticStatus> & status = robot_report_.status;
+    const unsigned int layout = (instrumented ? 1 : 0) | (latency ? 2 : 0);
+    if(layout != report_layout_)
+    {
+        status.resize((instrumented ? 1 : 0) + (latency ? 1 : 0));
+        report_layout_ = layout;
+        warm_tick_ = tick_count_;
+    }
+    if(instrumented)
+        status.front() = publish_status_;
+    if(latency)
+        status.back() = latency_status_;
+    robot_report_.header.stamp = ros::Time::now();
+    robot_report_.header.seq++;
+
+    unsigned long allocations = allocation_count();
+    diagnostics_pub_.publish(robot_report_);
+    publish_allocations_ += allocation_count() - allocations;
 }
 
-bool NubotGazebo::shoot_control_servive( nubot_common::Shoot::Request  &req,
-                                         nubot_common::Shoot::Response &res )
+void NubotGazebo::apply_ball_cmd(const ball_cmd & cmd)
+{
+    dribble_flag_ = cmd.dribble;
+    actuator_seq_ = cmd.seq;
+    shoot_done_   = cmd.shoot_done;
+    if(cmd.shoot_seq != shoot_seq_)             // a new Shoot request
+    {
+        shoot_seq_ = cmd.shoot_seq;
+        shot_flag_ = cmd.shoot;
+        force_     = cmd.force;
+        mode_      = cmd.mode;
+    }
+}
+
+bool NubotGazebo::request_dribble(int64_t enable, bool is_hold_ball)
 {
-    srvCB_lock_.lock();
+    srv_ball_cmd_.dribble = enable ? 1 : 0;             // FIXME. when robot is stucked, req.enable=2
+    if(srv_ball_cmd_.dribble)
+    {
+        if(!is_hold_ball)           // when dribble_flag is true, it does not necessarily mean that I can dribble it now.
+        {                           // it just means the dribble ball mechanism is working.
+            srv_ball_cmd_.dribble = false;
+            //ROS_INFO("%s dribble_service: Cannot dribble ball. angle error:%f distance error: %f",
+            //                              model_name_.c_str(), angle_error_degree_, nubot_football_vector_length_);
+            return false;
+        }
+        //ROS_INFO("%s dribble_service: dribbling ball now", model_name_.c_str());
+        srv_ball_cmd_.dribble  = true;
+        return true;
+    }
+    return is_hold_ball;
+}
 
-    force_ = (double)req.strength;
-    mode_ = (int)req.ShootPos;
-    if(force_ > 15.0)
+bool NubotGazebo::request_shoot(double strength, int pos, bool is_hold_ball)
+{
+    srv_ball_cmd_.shoot_seq++;
+    srv_ball_cmd_.force = strength;
+    srv_ball_cmd_.mode = pos;
+    if(srv_ball_cmd_.force > 15.0)
     {
-        //ROS_FATAL("Kick ball force(%f) is too great.", force_);
-        force_ = 15.0;
+        //ROS_FATAL("Kick ball force(%f) is too great.", srv_ball_cmd_.force);
+        srv_ball_cmd_.force = 15.0;
     }
-    if( force_ )
+    if( srv_ball_cmd_.force )
     {
-        if(get_is_hold_ball())
+        if(is_hold_ball)
         {
-            dribble_flag_ = false;
-            shot_flag_ = true;
-            //ROS_INFO("%s shoot_service: ShootPos:%d strength:%f",model_name_.c_str(), mode_, force_);
-            res.ShootIsDone = 1;
+            srv_ball_cmd_.dribble = false;
+            srv_ball_cmd_.shoot = true;
+            //ROS_INFO("%s shoot_service: ShootPos:%d strength:%f",model_name_.c_str(), srv_ball_cmd_.mode, srv_ball_cmd_.force);
+            srv_ball_cmd_.shoot_done = true;
         }
         else
         {
-            shot_flag_ = false;
-            res.ShootIsDone = 0;
+            srv_ball_cmd_.shoot = false;
+            srv_ball_cmd_.shoot_done = false;
             //ROS_INFO("%s shoot_service(): Cannot kick ball. angle error:%f distance error: %f. ",
             //                            model_name_.c_str(), angle_error_degree_, nubot_football_vector_length_);
         }
     }
     else
     {
-        shot_flag_ = false;
-        res.ShootIsDone = 1;
+        srv_ball_cmd_.shoot = false;
+        srv_ball_cmd_.shoot_done = true;
         //ROS_ERROR("%s shoot_control_service(): Kick-mechanism charging complete!",model_name_.c_str());
     }
+    return srv_ball_cmd_.shoot_done;
+}
 
-    //ROS_INFO("%s shoot: [strength pos shootisdone]:[%f %d %d]",
-    //            model_name_.c_str(), force_, mode_, (int)res.ShootIsDone);
+bool NubotGazebo::ball_handle_control_service(nubot_common::BallHandle::Request  &req,
+                                              nubot_common::BallHandle::Response &res)
+{
+    // ball holding state of the latest physics step
+    PluginStats::Scope lock_wait(stats_, STAT_CMD_LOCK_WAIT);
+    boost::mutex::scoped_lock lock(cmd_lock_);
+    lock_wait.stop();
+    stats_->count(COUNT_SERVICE_CALL);
+    ball_status_buf_.update();
+    res.BallIsHolding = request_dribble(req.enable, ball_status_buf_.read_buffer().is_hold_ball);
+
+    ball_cmd_buf_.write_buffer() = srv_ball_cmd_;
+    ball_cmd_buf_.publish();
 
-    srvCB_lock_.unlock();
+    // ROS_FATAL("%s dribble:[enable holding]:[%d %d]",model_name_.c_str(), (int)req.enable, (int)res.BallIsHolding);
     return true;
 }
 
-void NubotGazebo::dribble_ball(void)
+bool NubotGazebo::shoot_control_servive( nubot_common::Shoot::Request  &req,
+                                         nubot_common::Shoot::Response &res )
 {
+    PluginStats::Scope lock_wait(stats_, STAT_CMD_LOCK_WAIT);
+    boost::mutex::scoped_lock lock(cmd_lock_);
+    lock_wait.stop();
+    stats_->count(COUNT_SERVICE_CALL);
+    ball_status_buf_.update();
+    res.ShootIsDone = request_shoot((double)req.strength, (int)req.ShootPos, ball_status_buf_.read_buffer().is_hold_ball);
 
-#if 1
-    math::Quaternion    target_rot = robot_state_.pose.orient;
-    math::Vector3       relative_pos = kick_vector_world_* 0.43;
-    math::Vector3       target_pos;
-    if(flip_cord_)
-        target_pos = -(robot_state_.pose.position + relative_pos);
-    else
-        target_pos = robot_state_.pose.position + relative_pos;
+    ball_cmd_buf_.write_buffer() = srv_ball_cmd_;
+    ball_cmd_buf_.publish();
 
-    target_pos.z = 0.12;
-    //ROS_INFO("target pos:%f %f %f",target_pos.x, target_pos.y, target_pos.z);
-    math::Pose          target_pose(target_pos, target_rot);
-    ball_model_->SetLinearVel(math::Vector3(0,0,0));
-    ball_model_->SetWorldPose(target_pose);
-    ball_state_.twist.linear = robot_state_.twist.linear;
-#endif
-#if 0
-    const static double desired_nubot_football_vector_length =  dribble_distance_thres_;
-    if(ball_state_.pose.position.z > 0.3)   // if football is in the air, cannot dribble
-    {
-        ROS_ERROR("dribble_ball(): ball is in the air at %f; return!", ball_state_.pose.position.z);
-        return;
-    }
-
-    math::Vector3     nubot_linear_vel = nubot_model_->GetWorldLinearVel();
-    math::Vector3     nubot_angular_vel = nubot_model_->GetWorldAngularVel();
-    nubot_linear_vel.z=0; nubot_angular_vel.x=0; nubot_angular_vel.y=0;
-    // Set up the direction from nubot to football. Let vector lies in x-y plane
-    nubot_football_vector_.z = 0;                             // don't point to the air
-    math::Vector3     perpencular_vel = nubot_angular_vel.Cross(nubot_football_vector_);
-    math::Vector3     football_vel = nubot_linear_vel + perpencular_vel;
-    football_model_->SetLinearVel(football_vel);
-
-    ROS_INFO("%s dribble_ball(): dribbling ball. ball vel:%f %f", model_name_.c_str(),football_vel.x, football_vel.y);
-#endif
+    //ROS_INFO("%s shoot: [strength pos shootisdone]:[%f %d %d]",
+    //            model_name_.c_str(), srv_ball_cmd_.force, srv_ball_cmd_.mode, (int)res.ShootIsDone);
+    return true;
 }
 
-void NubotGazebo::kick_ball(int mode, double vel=20.0)
+void NubotGazebo::publish_actuator_state(void)
 {
-    math::Vector3 kick_vector_planar(kick_vector_world_.x, kick_vector_world_.y, 0.0);
-    math::Vector3 vel_vector;
+    if(!actuator_state_pub_.getNumSubscribers())
+        return;
+    actuator_state_.header.stamp = ros::Time::now();
+    actuator_state_.header.seq++;
+    actuator_state_.seq = actuator_seq_;
+    actuator_state_.BallIsHolding = is_hold_ball_;
+    actuator_state_.ShootIsDone = shoot_done_;
+    actuator_state_.RobotStuck = is_stuck_;
+
+    unsigned long allocations = allocation_count();
+    actuator_state_pub_.publish(actuator_state_);
+    publish_allocations_ += allocation_count() - allocations;
+}
 
-    if(mode == RUN)
-    {
-        double vel2 = vel * 2.3;;                         //FIXME. CAN TUNE
-        if(flip_cord_)
-            vel_vector = -kick_vector_planar * vel2;
-        else
-            vel_vector = kick_vector_planar * vel2;
-
-        ball_model_->SetLinearVel(vel_vector);
-        ROS_INFO("kick ball vel:%f vel2:%f",vel, vel2);
-    }
-    else if(mode == FLY)
-    {
-        // math formular: y = a*x^2 + b*x + c;
-        //  a = -g/(2*vx*vx), c = 0, b = kick_goal_height/D + g*D/(2.0*vx*vx)
-        //  mid_point coordinates:[-b/(2*a), (4a*c-b^2)/(4a) ]
-
-        static const double g = 9.8, kick_goal_height = goal_height - 0.20;      // FIXME: can be tuned
-        nubot::DPoint point1(robot_state_.pose.position.x,robot_state_.pose.position.y);
-        nubot::DPoint point2(robot_state_.pose.position.x + kick_vector_world_.x,
-                             robot_state_.pose.position.y + kick_vector_world_.y);
-        nubot::DPoint point3(ball_state_.pose.position.x,ball_state_.pose.position.y);
-        nubot::Line_ line1(point1, point2);
-        nubot::Line_ line2(1.0, 0.0, kick_vector_world_.x>0 ? -goal_x : goal_x);         // nubot::Line_(A,B,C);
-
-        nubot::DPoint crosspoint = line1.crosspoint(line2);
-        double D = crosspoint.distance(point3);
-        double vx_thres = D*sqrt(g/2/kick_goal_height);
-        double vx = vx_thres/2.0;//>vel ? vel : vx_thres/2.0;                            // initial x velocity.CAN BE TUNED
-        double b = kick_goal_height/D + g*D/(2.0*vx*vx);
-
-        ROS_INFO("%s crosspoint:(%f %f) vx: %f", model_name_.c_str(),
-                 crosspoint.x_, crosspoint.y_, vx);
-        if( fabs(crosspoint.y_) < 10)
-        {
-            math::Vector3 kick_vector;
-            if(flip_cord_)
-                kick_vector = math::Vector3(-vx*kick_vector_world_.x, -vx*kick_vector_world_.y, b*vx);
-            else
-                kick_vector = math::Vector3(vx*kick_vector_world_.x, vx*kick_vector_world_.y, b*vx);
-            ball_model_->SetLinearVel(kick_vector);
-        }
-        else
-            ROS_FATAL("CANNOT SHOOT. crosspoint.y is too big!");
-    }
-    else
-    {
-        ROS_ERROR("%s kick_ball(): Incorrect mode!", model_name_.c_str());
-    }
+void NubotGazebo::set_robot_velocity(double vx, double vy, double w)
+{
+    // planar movement
+    set_vx_ = vx;
+    set_vy_ = vy;
+    set_w_  = w;
+    robot_model_->SetLinearVel(math::Vector3(vx, vy, 0));
+    robot_model_->SetAngularVel(math::Vector3(0, 0, w));
 }
 
-bool NubotGazebo::get_is_hold_ball(void)
+double NubotGazebo::robot_height(void) const
 {
-    bool near_ball, allign_ball;
-    math::Vector3 norm = nubot_ball_vec_;
-    norm.z=0.0; norm.Normalize();
-    kick_vector_world_.z=0.0;
-    angle_error_degree_ = get_angle_PI(kick_vector_world_,norm)*(180/PI);
+    return robot_model_->GetWorldPose().pos.z;
+}
 
-    allign_ball = (angle_error_degree_ <= dribble_angle_thres_/2.0
-                   && angle_error_degree_ >= -dribble_angle_thres_/2.0) ?
-                1 : 0;
-    near_ball = nubot_ball_vec_len_ <= dribble_distance_thres_ ?
-                1 : 0;
+void NubotGazebo::set_ball_pose(double x, double y, double z, double yaw)
+{
+    // x and y are in the field's frame
+    ball_model_->SetLinearVel(math::Vector3(0,0,0));
+    ball_model_->SetWorldPose(math::Pose(math::Vector3(x + field_.origin_x, y + field_.origin_y, z),
+                                         math::Quaternion(0.0, 0.0, yaw)));
+}
 
-    //ROS_INFO("%s get_is_hold_ball(): angle error:%f(thres:%f) distance_error:%f(thres:%f)",
-    //         model_name_.c_str(),  angle_error_degree_, dribble_angle_thres_,
-    //         nubot_football_vector_length_, dribble_distance_thres_);
+void NubotGazebo::set_ball_velocity(double vx, double vy, double vz)
+{
+    ball_model_->SetLinearVel(math::Vector3(vx, vy, vz));
+}
 
-    return (near_ball && allign_ball);
+void NubotGazebo::kick_ball(int mode, double vel=20.0)
+{
+    kick_result result = behaviour_.kick_ball(mode, vel, *this);
+    if(result == KICK_OUT_OF_RANGE)
+        ROS_FATAL("CANNOT SHOOT. crosspoint.y is too big!");
+    else if(result == KICK_BAD_MODE)
+        ROS_ERROR("%s kick_ball(): Incorrect mode!", model_name_.c_str());
+    else
+        ROS_INFO("%s kick ball mode:%d vel:%f", model_name_.c_str(), mode, vel);
 }
 
-bool NubotGazebo::get_nubot_stuck(void)
+void NubotGazebo::get_params(void)
 {
-    static int time_count=0;
-    static bool last_time_stuck=0;
-    static const int time_limit = 40;
-    static bool is_stuck;
+    noise_scale_            = noise_scale_param_->get();
+    noise_rate_             = noise_rate_param_->get();
+    behaviour_.set_params(noise_scale_, noise_rate_);
+}
 
-    if(judge_nubot_stuck_)
+void NubotGazebo::update_child()
+{
+    StepTimer::Scope step_timer(step_timer_, world_->GetIterations());
+    unsigned long allocations = allocation_count();
+    publish_allocations_ = 0;
+
+    /* the world state is read in-process from physics::World,
+     * so nubot moves on the states of the current iteration. */
+    PluginStats::Scope snapshot_time(stats_, STAT_SNAPSHOT);
+    const WorldSnapshot & snapshot = world_state_->snapshot();
+    snapshot_time.stop();
+    get_params();
+    PluginStats::Scope perception_time(stats_, STAT_PERCEPTION);
+    bool model_updated = update_model_info(snapshot);
+    perception_time.stop();
+
+    // team-wide world model; roscpp's serialization is not counted as our allocation
+    if(team_world_)
     {
-        judge_nubot_stuck_ = 0;
-        static const double scale = 0.5;                                    // FIXME. Can tune
-        double desired_trans_length = desired_trans_vector_.GetLength();
-        double desired_rot_length   = desired_rot_vector_.z>0 ?
-                    desired_rot_vector_.z :-desired_rot_vector_.z ;
-        double actual_trans_length  = robot_state_.twist.linear.GetLength();
-        double actual_rot_length    = robot_state_.twist.angular.z>0 ?
-                    robot_state_.twist.angular.z : -robot_state_.twist.angular.z;
-
-        //ROS_INFO("%s time_count:%d, last_time_stuck:%d",model_name_.c_str(), time_count, last_time_stuck);
-        //ROS_INFO("desired_trans_len:%f actual_trans_len:%f",desired_trans_length,actual_trans_length);
-        //ROS_INFO("desired_rot_len:%f actual_rot_len:%f",desired_rot_length, actual_rot_length);
-
-        if(actual_trans_length < desired_trans_length * scale)
-        {
-            if(last_time_stuck)
-                time_count++;
-            else
-                time_count = 0;
-
-            last_time_stuck = 1;
-            if(time_count > time_limit)
-            {
-                // ROS_INFO("get_nubot_stuck(): desired_trans:%f actual_trans:%f", desired_trans_length, actual_trans_length);
-                // ROS_INFO("%s get_nubot_stuck(): cannot translate!", model_name_.c_str());
-                time_count = 0;
-                is_stuck = 1;
-            }
-        }
-        else if(actual_rot_length < desired_rot_length * scale)
-        {
-            if(last_time_stuck)
-                time_count++;
-            else
-                time_count = 0;
-
-            last_time_stuck = 1;
-            if(time_count > time_limit)
-            {
-                // ROS_INFO("desired_rot:%f actual_rot:%f", desired_rot_length, actual_rot_length);
-                // ROS_ERROR("%s get_nubot_stuck(): cannot rotate!", model_name_.c_str());
-                time_count = 0;
-                is_stuck = 1;
-            }
-        }
-        else
-        {
-            last_time_stuck = 0;
-            is_stuck = 0;
-        }
-
-        return is_stuck;
+        PluginStats::Scope publish_time(stats_, STAT_PUBLISH);
+        team_world_->update(snapshot, publish_allocations_);
     }
+    if(stats_->enabled())
+        stats_->record(STAT_QUEUE_DEPTH, message_queue_->size() + service_queue_->size());
+
+    // take the latest commands; the callback threads never block this thread
+    tick_count_++;
+    stats_->count(COUNT_ROBOT_STEP);
+    if(vel_cmd_buf_.update())
+        apply_vel_cmd(vel_cmd_buf_.read_buffer());
     else
     {
-        //ROS_FATAL("%s judge_nubot_stuck_flag not set!", model_name_.c_str());
-        return 0;
+        stats_->count(COUNT_STALE_VEL_CMD);
+        if(hold_vel_cmd_)
+            apply_vel_cmd(vel_cmd_buf_.read_buffer());
     }
-}
+    if(ball_cmd_buf_.update())
+        apply_ball_cmd(ball_cmd_buf_.read_buffer());
+    else
+        stats_->count(COUNT_STALE_BALL_CMD);
 
-void NubotGazebo::update_child()
-{
-    msgCB_lock_.lock(); // lock access to fields that are used in ROS message callbacks
-    srvCB_lock_.lock();
-    /* delay in model_states messages publishing
-     * so after receiving model_states message, then nubot moves. */
-    if(update_model_info())
+    if(model_updated)
     {
         /********** EDIT BEGINS **********/
 
@@ -761,26 +773,47 @@ void NubotGazebo::update_child()
         // nubot_test();
 
         /**********  EDIT ENDS  **********/
+
+        // hand the ball holding state over to the service callbacks
+        ball_status_buf_.write_buffer().is_hold_ball = is_hold_ball_;
+        ball_status_buf_.publish();
+        publish_actuator_state();
+    }
+    report_diagnostics();
+
+    // after warm-up, a step must not allocate; only checked if libnubot_alloc_counter.so is preloaded.
+    // The robot's own part and its team's WorldModelInfo are checked by test/steady_state_allocation.cc
+    // in every build.
+    allocations = allocation_count() - allocations - publish_allocations_;
+    if(allocations && registry_version_ == warm_version_ && tick_count_ > warm_tick_ + 10)
+    {
+        steady_allocation_count_ += allocations;
+        ROS_ERROR_THROTTLE(1.0, "%s update_child(): %lu heap allocations in a steady-state step (%lu in total)",
+                           model_name_.c_str(), allocations, steady_allocation_count_);
+    }
+    if(registry_version_ != warm_version_)
+    {
+        warm_version_ = registry_version_;
+        warm_tick_ = tick_count_;
     }
-    srvCB_lock_.unlock();
-    msgCB_lock_.unlock();
 }
 
 void NubotGazebo::nubot_be_control(void)
 {
     static int count=0;
-    if(robot_state_.pose.position.z < 0.2)      // not in the air
+    PluginStats::Scope ball_handling_time(stats_, STAT_BALL_HANDLING);
+    if(behaviour_.robot().z < 0.2)              // not in the air
     {
         //if(dribble_flag_)                       // dribble_flag_ is set by BallHandle service
         //{
-        //    if(get_is_hold_ball())
+        //    if(behaviour_.is_hold_ball())
         //        dribble_ball();
         //    else
         //        dribble_flag_ = false;
         //}
 
-        if(dribble_flag_ && get_is_hold_ball())                       // dribble_flag_ is set by BallHandle service
-            dribble_ball();
+        if(dribble_flag_ && is_hold_ball_)                // dribble_flag_ is set by BallHandle service
+            behaviour_.dribble_ball(*this);
 
         if(shot_flag_)
         {
@@ -790,25 +823,46 @@ void NubotGazebo::nubot_be_control(void)
     }
     else
         ROS_FATAL("%s in the air!",model_name_.c_str());
+    ball_handling_time.stop();
+
+    if(omni_scheduler_.should_publish(sim_time_, state_change()))
+    {
+        PluginStats::Scope publish_time(stats_, STAT_PUBLISH);
+        message_publish();                      // publish message to world_model node
+        if(omni_scheduler_.change_triggered())
+            last_published_ = behaviour_.perceived();
+    }
+}
+
+double NubotGazebo::state_change(void)
+{
+    if(!omni_scheduler_.change_triggered())
+        return 0.0;
+    const PlanarStates & perceived = behaviour_.perceived();
+    if(last_published_.size() != perceived.size())     // models added or removed
+        return std::numeric_limits<double>::max();
 
-    message_publish();                          // publish message to world_model node
+    double change = 0.0;
+    for(unsigned int i=0; i<perceived.size(); i++)
+    {
+        change = std::max(change, fabs(perceived.x[i] - last_published_.x[i]));
+        change = std::max(change, fabs(perceived.y[i] - last_published_.y[i]));
+    }
+    return change;
 }
 
 bool NubotGazebo::is_robot_valid(double x, double y)
 {
-    if(fabs(x) > 10 || fabs(y) > 7)
-        return false;
-    else
-        return true;
+    return in_field(x, y);
 }
 
 void NubotGazebo::nubot_test(void)
 {
     // dribble ball
 #if 0
-    nubot_locomotion(math::Vector3(5,0,0),math::Vector3(0,0,2);
-            dribble_ball();
-    ROS_INFO("nubot-football distance:%f",nubot_football_vector_length_);
+    behaviour_.move(5, 0, 2, *this);
+    behaviour_.dribble_ball(*this);
+    ROS_INFO("nubot-football distance:%f",behaviour_.ball_range());
 #endif
     // kick ball
 #if 0
@@ -821,9 +875,9 @@ void NubotGazebo::nubot_test(void)
 #endif
     // get nubot stuck flag test
 #if 0
-    bool a=get_nubot_stuck();
+    bool a=behaviour_.stuck();
     ROS_FATAL("%d",a);
-    nubot_locomotion(math::Vector3(0,0,0),math::Vector3(0,0,1));
+    behaviour_.move(0, 0, 1, *this);
 #endif
     //for testing velocity decay
 #if 0
@@ -855,7 +909,7 @@ void NubotGazebo::nubot_test(void)
 #if 0
     double vel = nubot_model_->GetWorldLinearVel().GetLength();
     //double vel2 = nubot_state_.twist.linear.x;
-    nubot_locomotion(math::Vector3(1,0,0),ZERO_VECTOR);
+    behaviour_.move(1, 0, 0, *this);
     //ROS_INFO("function:%f state:%f",vel,vel2);
     debug_msgs_.data.clear();
     debug_msgs_.data.push_back(vel);
@@ -12,22 +12,40 @@
 
 #include <ros/callback_queue.h>         // Custom Callback Queue
 #include <ros/subscribe_options.h>
-#include <gazebo_msgs/ModelStates.h>
-#include <gazebo_msgs/ModelState.h>
 #include "nubot_common/OminiVisionInfo.h"
 #include "nubot_common/VelCmd.h"
+#include "nubot_common/VelCmdStamped.h"
+#include "nubot_common/OdoInfo.h"
 #include "nubot_common/Shoot.h"
 #include "nubot_common/BallHandle.h"
+#include "nubot_common/ActuatorCmd.h"
+#include "nubot_common/ActuatorState.h"
+#include "nubot_common/TeamActuatorCmd.h"
 #include <std_msgs/Float64MultiArray.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
 #include <geometry_msgs/Pose.h>
 #include <geometry_msgs/Twist.h>
 
 #include <ros/ros.h>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
+#include <atomic>
 #include <string>
 
 #include "nubot/core/core.hpp"
+#include "world_state.hh"
+#include "field_layout.hh"
+#include "triple_buffer.hh"
+#include "callback_executor.hh"
+#include "publish_scheduler.hh"
+#include "robot_behaviour.hh"
+#include "robot_messages.hh"
+#include "param_store.hh"
+#include "step_timer.hh"
+#include "plugin_stats.hh"
+#include "command_latency.hh"
+#include "lockstep_server.hh"
+#include "team_world_publisher.hh"
 
 #include <nubot_gazebo/NubotGazeboConfig.h>
 #include <dynamic_reconfigure/server.h>
@@ -47,32 +65,40 @@ enum nubot_substate
 };
 
 namespace gazebo{
-   struct Pose
+   /// \brief Velocity command handed from the message callback thread to the physics thread
+   struct vel_cmd
    {
-       math::Vector3    position;
-       math::Quaternion orient;
+       double Vx;                   // m/s, coordinate frame already flipped
+       double Vy;
+       double w;                    // rad/s
+       bool   stamped;              // came in on velcmd_stamped; the fields below are only set then
+       uint32_t seq;                // command id
+       double sent;                 // wall time the controller sent it (s)
+       double received;             // wall time the callback took it (s)
    };
-   struct Twist
+
+   /// \brief Ball handling requests handed from the service callback thread to the physics thread
+   struct ball_cmd
    {
-       math::Vector3    linear;
-       math::Vector3    angular;
+       bool         dribble;        // BallHandle enabled and robot is able to dribble
+       bool         shoot;          // last Shoot request is to be executed
+       unsigned int shoot_seq;      // increased on every Shoot request
+       double       force;          // kick ball force
+       int          mode;           // kick ball mode
+       uint32_t     seq;            // id of the last ActuatorCmd; 0 if none
+       bool         shoot_done;     // ShootIsDone of the last Shoot request
    };
 
-   struct model_state
-   {
-       std::string model_name;
-       Pose        pose;
-       Twist       twist;
-       std::string reference_frame;
-   };                                       // similar to the type gazebo_msgs::ModelState;
-                                            // use these structs for easy handling of model states.
-   struct Obstacles
+   /// \brief State handed from the physics thread to the service callback thread
+   struct ball_status
    {
-       std::vector<nubot::PPoint> real_obs_;
-       std::vector<nubot::DPoint> world_obs_;
+       bool is_hold_ball;
    };
 
-  class NubotGazebo : public ModelPlugin
+  /// \class NubotGazebo
+  /// \brief Adapter of RobotBehaviour to Gazebo and ROS: takes the world state and the commands,
+  /// drives the robot and football models and publishes the robot's messages.
+  class NubotGazebo : public ModelPlugin, public LockstepRobot, public PhysicsBackend
   {      
     private: 
 
@@ -82,48 +108,65 @@ namespace gazebo{
         physics::LinkPtr            ball_link_;     //Pointer to the football link
         
         ros::NodeHandle*            rosnode_;           // A pointer to the ROS node. 
-        ros::Subscriber             ModelStates_sub_;
         ros::Subscriber             Velcmd_sub_;
+        ros::Subscriber             velcmd_stamped_sub_;   // optional stamped commands, for latency tracing
+        ros::Subscriber             actuator_sub_;         // velocity and ball handling in one message
+        ros::Subscriber             team_actuator_sub_;    // ... batched for the whole team by the team host
+        ros::Publisher              actuator_state_pub_;   // per-step answer to actuator_sub_
         ros::Publisher              omin_vision_pub_;      /* four publishers cooresponding to those in world_model.cpp */
+        ros::Publisher              odo_info_pub_;         // odometry and stuck flag
         ros::Publisher              debug_pub_;
+        ros::Publisher              diagnostics_pub_;      // publish rate and command latency on /diagnostics
         ros::ServiceServer          ballhandle_server_;
         ros::ServiceServer          shoot_server_;
 
-        boost::thread               message_callback_queue_thread_;     // Thead object for the running callback Thread.
-        boost::thread               service_callback_queue_thread_;
-        boost::mutex                msgCB_lock_;        // A mutex to lock access to fields that are used in ROS message callbacks
-        boost::mutex                srvCB_lock_;        // A mutex to lock access to fields that are used in ROS service callbacks
-        ros::CallbackQueue          message_queue_;     // Custom Callback Queue. Details see http://wiki.ros.org/roscpp/Overview/Callbacks%20and%20Spinning
-        ros::CallbackQueue          service_queue_;     // Custom Callback Queue
+        TripleBuffer<vel_cmd>       vel_cmd_buf_;       // message callbacks -> physics thread
+        TripleBuffer<ball_cmd>      ball_cmd_buf_;      // service callbacks -> physics thread
+        TripleBuffer<ball_status>   ball_status_buf_;   // physics thread -> service callbacks
+        ball_cmd                    srv_ball_cmd_;      // latest ball handling requests; service thread only
+        unsigned int                shoot_seq_;         // last Shoot request handled by the physics thread
+        uint32_t                    actuator_seq_;      // last ActuatorCmd handled by the physics thread
+        bool                        shoot_done_;        // ... and ShootIsDone of its last Shoot request
+        nubot_common::ActuatorState actuator_state_;    // filled in place every step
+        unsigned long               tick_count_;        // physics steps seen by update_child
+        unsigned long               publish_allocations_;   // allocations made by roscpp when publishing in this step
+        unsigned long               steady_allocation_count_;   // allocations in steady-state steps
+        unsigned long               warm_tick_;             // step at which the message buffers were last resized
+        unsigned int                warm_version_;          // registry version at warm_tick_
+        bool                        is_stuck_;              // result of stuck detection in this step
+        bool                        is_hold_ball_;          // this robot holds the ball in this step, see BallPossession
+        StrandQueuePtr              message_queue_;     // Custom Callback Queue served by the shared CallbackExecutor.
+                                                        // Details see http://wiki.ros.org/roscpp/Overview/Callbacks%20and%20Spinning
+        StrandQueuePtr              service_queue_;     // Custom Callback Queue served by the shared CallbackExecutor
+        boost::mutex                cmd_lock_;          // serializes the writers of vel_cmd_buf_ and ball_cmd_buf_
+                                                        // (and the reader of ball_status_buf_); never taken by physics
+        LockstepServer*             lockstep_;          // NULL unless /general/lockstep is set
+        std::atomic<bool>           hold_vel_cmd_;      // re-apply the last velocity command every step (lockstep)
         event::ConnectionPtr        update_connection_;         // Pointer to the update event connection
         
-        gazebo_msgs::ModelStates    model_states_;          // Container for the ModelStates msg
-        model_state                 robot_state_;
-        model_state                 ball_state_;
-        nubot_common::BallInfo        ball_info_;
-        nubot_common::RobotInfo       teamate_info_;
-        nubot_common::ObstaclesInfo   obstacles_info_;
-        nubot_common::OminiVisionInfo omni_info_;
+        WorldStateCache*            world_state_;          // World state shared by all robot plugins
+        TeamWorldPublisher*         team_world_;           // WorldModelInfo of this robot's team, shared by its robots
+        RobotBehaviour              behaviour_;            // perception, ball handling and stuck detection
+        PlanarStates                last_published_;       // perceived state at the last OmniVisionInfo publish
+        PublishScheduler            omni_scheduler_;       // decides when to publish OmniVisionInfo
+        double                      sim_time_;             // simulation time of the current step (s)
+        nubot_common::OminiVisionInfo omni_info_;             // filled in place; sized on registry changes
+        nubot_common::OdoInfo         odo_info_;
+        std::vector<int>            obstacles_;            // indices of the other robots in the snapshot, as in omni_info_
         //common::Time                  receive_sim_time_;
         std_msgs::Float64MultiArray   debug_msgs_;
 
-        math::Vector3               desired_rot_vector_;
-        math::Vector3               desired_trans_vector_;
-        math::Vector3               nubot_ball_vec_;
-        math::Vector3               kick_vector_world_;
-        math::Rand                  rand_;
-        std::string                 robot_namespace_;   // robot namespace. Not used yet.
+        std::string                 robot_namespace_;   // robot namespace, e.g. "nubot1" or "field2/nubot1"
         std::string                 model_name_;
+        field_layout                field_;             // the field this robot plays on
         std::string                 ball_name_;
         std::string                 ball_chassis_;
         std::string                 cyan_pre_;
         std::string                 mag_pre_;
-        unsigned int                ball_index_;
-        unsigned int                robot_index_;
+        int                         ball_index_;                // index of the football in the world snapshot
+        int                         robot_index_;               // index of myself in the world snapshot; -1 if not found
+        unsigned int                registry_version_;          // registry version robot_index_ belongs to
 
-        double                      nubot_ball_vec_len_;
-        double                      dribble_distance_thres_;
-        double                      dribble_angle_thres_;
         double                      Vx_cmd_;
         double                      Vy_cmd_;
         double                      w_cmd_;
@@ -135,35 +178,91 @@ namespace gazebo{
         double                      I_term_min_;                // minimum I term
         double                      field_length_;
         double                      field_width_;
-        double                      angle_error_degree_;
         double                      noise_scale_;               // scale of gaussian noise
         double                      noise_rate_;                // how frequent the noise generates
+        uint64_t                    noise_seed_;                // base seed of the noise streams of all robots
+        const ParamValue*           noise_scale_param_;         // run-time tunable values of the members above
+        const ParamValue*           noise_rate_param_;
+        StepTimer*                  step_timer_;                // time spent in plugins per physics step
+        PluginStats*                stats_;                     // per-stage timings, off unless /general/instrumentation is set
+        CommandLatency              latency_;                   // stages of stamped velocity commands
+        diagnostic_msgs::DiagnosticArray robot_report_;         // statuses of this robot on /diagnostics
+        diagnostic_msgs::DiagnosticStatus publish_status_;      // OmniVisionInfo publish rate
+        diagnostic_msgs::DiagnosticStatus latency_status_;      // command latency
+        unsigned int                report_layout_;             // statuses in robot_report_: 1 publishing, 2 latency
+        const ParamValue*           report_period_param_;       // /general/instrumentation_period (s)
+        double                      last_report_;               // wall time (s)
+        uint32_t                    traced_seq_;                // last stamped command handed to latency_
+        bool                        latency_traced_;            // a stamped command has arrived
+        double                      set_vx_, set_vy_, set_w_;   // velocity last set on the robot, world frame
         int                         mode_;                      //kick ball mode
         int                         nubot_num_;
         
-        unsigned int                model_count_;                // Number of models
         bool                        dribble_flag_;
         bool                        shot_flag_;
-        bool                        ModelStatesCB_flag_;         // Indicate receiving messages
-        bool                        judge_nubot_stuck_;          // decide when to judge
         bool                        is_kick_;
         bool                        flip_cord_;                 // flip the coordinate frame
 
         int                         AgentID_;
+        int                         my_team_;                   // CYAN_TEAM or MAGENTA_TEAM
 
         nubot_state                 state_;
         nubot_substate              sub_state_;
-        Obstacles                   *obs_;
         dynamic_reconfigure::Server<nubot_gazebo::NubotGazeboConfig> *reconfigureServer_;
 
-        /// \brief ModelStates message CallBack function
-        /// \param[in] _msg model_states msg shared pointer
-        void model_states_CB(const gazebo_msgs::ModelStates::ConstPtr& _msg);
-
         /// \brief VelCmd message CallBack function
         /// \param[in] cmd VelCmd msg shared pointer
         void vel_cmd_CB(const nubot_common::VelCmd::ConstPtr& cmd);
 
+        /// \brief Stamped VelCmd message callback; the command takes the same path as on velcmd
+        /// and its stages are traced by latency_
+        void vel_cmd_stamped_CB(const nubot_common::VelCmdStamped::ConstPtr& cmd);
+
+        /// \brief Hand a velocity command over to the physics thread. Caller holds cmd_lock_.
+        /// \param[in] cmd velocity command in the robot's own frame (cm/s, rad/s)
+        /// \param[in] stamp header of a stamped command; NULL for plain commands
+        /// \param[in] received wall time the callback took a stamped command (s)
+        void write_vel_cmd(const nubot_common::VelCmd & cmd, const std_msgs::Header * stamp = NULL,
+                           double received = 0.0);
+
+        /// \brief Publish the statuses of this robot once per instrumentation period: the achieved
+        /// OmniVisionInfo rate if instrumentation is on, the command latency if commands are stamped
+        void report_diagnostics(void);
+
+        /// \brief Apply a velocity command. Physics thread only.
+        /// \param[in] cmd velocity command taken from vel_cmd_buf_
+        void apply_vel_cmd(const vel_cmd & cmd);
+
+        /// \brief Apply ball handling requests. Physics thread only.
+        /// \param[in] cmd requests taken from ball_cmd_buf_
+        void apply_ball_cmd(const ball_cmd & cmd);
+
+        /// \brief ActuatorCmd message callback: velocity, dribble and kick in one message, without
+        /// the round trips of the BallHandle and Shoot services; answered on actuator_state
+        void actuator_CB(const nubot_common::ActuatorCmd::ConstPtr& cmd);
+
+        /// \brief TeamActuatorCmd message callback: the commands of the whole team in one message;
+        /// takes the one addressed to this robot, as actuator_CB()
+        void team_actuator_CB(const nubot_common::TeamActuatorCmd::ConstPtr& cmds);
+
+        /// \brief Hand over an ActuatorCmd. Caller holds cmd_lock_.
+        void write_actuator_cmd(const nubot_common::ActuatorCmd & cmd);
+
+        /// \brief Update srv_ball_cmd_ with a BallHandle request. Caller holds cmd_lock_.
+        /// \param[in] enable as BallHandle.enable
+        /// \param[in] is_hold_ball ball holding state of the latest physics step
+        /// \return BallIsHolding
+        bool request_dribble(int64_t enable, bool is_hold_ball);
+
+        /// \brief Update srv_ball_cmd_ with a Shoot request. Caller holds cmd_lock_.
+        /// \param[in] strength, pos as Shoot.strength and Shoot.ShootPos
+        /// \param[in] is_hold_ball ball holding state of the latest physics step
+        /// \return ShootIsDone
+        bool request_shoot(double strength, int pos, bool is_hold_ball);
+
+        /// \brief Publish the actuator state of this step if anyone listens. Physics thread only.
+        void publish_actuator_state(void);
+
         /// \brief Ball handling service
         /// \param[in] req ball handle service request
         /// \param[out] res ball handle service response
@@ -176,40 +275,29 @@ namespace gazebo{
         bool shoot_control_servive(nubot_common::Shoot::Request  &req,
                                  nubot_common::Shoot::Response &res);
 
-        /// \brief Custom message callback queue thread
-        void message_queue_thread();
-
-        /// \brief Custom service callback queue thread
-        void service_queue_thread();
-
         /// \brief Updating models' states
+        /// \param[in] snapshot world state of the current iteration
         /// \return 1: updating model info success 0: not success
-        bool update_model_info(void);
-
-        /// \brief Nubot moving fuction: rotation + translation
-        /// \param[in] linear_vel_vector translation velocity 3D vector
-        /// \param[in] angular_vel_vector rotation velocity 3D vector
-        void nubot_locomotion(math::Vector3 linear_vel_vector, math::Vector3 angular_vel_vector);
+        bool update_model_info(const WorldSnapshot & snapshot);
 
-        /// \brief Nubot dribbling ball function. The football follows nubot movement.
-        void dribble_ball(void);
+        /// \brief Copy the current values of the tunable parameters into the members; once per step
+        void get_params(void);
 
-        /// \brief Nubot kicking ball
+        /// \brief Nubot kicking ball; logs what the behaviour did
         /// \param[in] mode kick ball mode FLY or RUN
         /// \param[in] vel initial velocity of the ball kicked; used in RUN mode; not used in FLY mode
         void kick_ball(int mode, double vel);
 
-        /// \brief  Get the value of flag is_hold_ball_
-        /// \return 1: is holding ball 0: is not holding ball
-        bool get_is_hold_ball(void);
-
-        /// \brief Determine whether nubot stuck or not.
-        /// \return 1: stuck 0: not stuck
-        bool get_nubot_stuck(void);
+        /// \brief Fill omni_info_ and odo_info_ with the state of the current step
+        void fill_omni_info(void);
 
         /// \brief Publish messages to world_model node
         void message_publish(void);
 
+        /// \brief How much the perceived state changed since the last OmniVisionInfo publish
+        /// \return largest displacement of any agent (m); 0 if publishing is not change-triggered
+        double state_change(void);
+
         /// \brief Robot action controlled by real-robot code. Need to connect to coach.
         void nubot_be_control(void);
 
@@ -225,18 +313,24 @@ namespace gazebo{
         /// \param[out] if robot is valid, return true, otherwise return false
         bool is_robot_valid(double x, double y);
 
-        /// \brief return a value representing real world noise. The noise complies with Normal(gaussian) distribution
-        /// with mean 0 and derivation 1, that is noise~N(0,1)
-        /// \param[in] scale            the magnitude of the noise is within [0, scale]
-        /// \param[in] probability      the probability of generating noise, probability should be in [0,1]
-        double  noise(double scale, double probability=0.01);
-
     public:        
         /// \brief Constructor. Will be called firstly
         NubotGazebo();
 
         /// \brief Destructor
         virtual ~NubotGazebo();
+
+        /// \brief Lockstep mode: apply velcmd, BallHandle and Shoot in one go. See LockstepServer.
+        virtual void lockstep_command(const nubot_common::ActuatorCmd & cmd);
+
+        /// \brief Lockstep mode: OmniVisionInfo and ball holding state of the current step
+        virtual void lockstep_state(nubot_common::OminiVisionInfo & info, bool & is_hold_ball);
+
+        /// \brief PhysicsBackend on the robot and football models. Physics thread only.
+        virtual void set_robot_velocity(double vx, double vy, double w);
+        virtual double robot_height(void) const;
+        virtual void set_ball_pose(double x, double y, double z, double yaw);
+        virtual void set_ball_velocity(double vx, double vy, double vz);
     
     protected:   
         /// \brief Load the controller.
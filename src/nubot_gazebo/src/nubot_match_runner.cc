@@ -0,0 +1,125 @@
+/* Desc: plays many independent matches in the 2D kinematic simulation on all CPU cores and
+ * writes one line per match into a summary file.
+ * Usage: rosrun nubot_gazebo nubot_match_runner [--matches N] [--threads N] [--duration S]
+ *        [--seed S] [--cyan N] [--magenta N] [--field-length M] [--field-width M]
+ *        [--step-size S] [--jitter M] [--output FILE]
+ */
+
+#include <boost/thread.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "match_runner.hh"
+
+using namespace gazebo;
+
+/// \brief Play the matches handed out by a shared counter until none is left
+static void worker(const match_config * base, int matches, std::atomic<int> * next,
+                   std::vector<match_result> * results)
+{
+    int i;
+    while((i = next->fetch_add(1)) < matches)
+    {
+        match_config config = *base;
+        config.seed = base->seed + i;                   // match i is reproducible on its own
+        Match match(config);
+        (*results)[i] = match.play();
+    }
+}
+
+static void usage(const char * name)
+{
+    fprintf(stderr, "usage: %s [--matches N] [--threads N] [--duration S] [--seed S] [--cyan N] [--magenta N]\n"
+                    "       [--field-length M] [--field-width M] [--step-size S] [--jitter M] [--output FILE]\n", name);
+}
+
+int main(int argc, char **argv)
+{
+    match_config config;
+    int matches = 100;
+    int threads = boost::thread::hardware_concurrency();
+    std::string output = "match_results.csv";
+
+    for(int i=1; i<argc; i++)
+    {
+        if(i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 1;
+        }
+        const char * value = argv[++i];
+        if(!strcmp(argv[i-1], "--matches"))             matches = atoi(value);
+        else if(!strcmp(argv[i-1], "--threads"))        threads = atoi(value);
+        else if(!strcmp(argv[i-1], "--duration"))       config.duration = atof(value);
+        else if(!strcmp(argv[i-1], "--seed"))           config.seed = strtoull(value, NULL, 10);
+        else if(!strcmp(argv[i-1], "--cyan"))           config.cyan_num = atoi(value);
+        else if(!strcmp(argv[i-1], "--magenta"))        config.magenta_num = atoi(value);
+        else if(!strcmp(argv[i-1], "--field-length"))   config.field_length = atof(value);
+        else if(!strcmp(argv[i-1], "--field-width"))    config.field_width = atof(value);
+        else if(!strcmp(argv[i-1], "--step-size"))      config.step_size = atof(value);
+        else if(!strcmp(argv[i-1], "--jitter"))         config.start_jitter = atof(value);
+        else if(!strcmp(argv[i-1], "--output"))         output = value;
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(threads < 1)
+        threads = 1;
+
+    // matches share nothing but the counter, so throughput scales with the number of cores
+    std::vector<match_result> results(matches);
+    std::atomic<int> next(0);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    boost::thread_group workers;
+    for(int i=0; i<threads; i++)
+        workers.create_thread(boost::bind(&worker, &config, matches, &next, &results));
+    workers.join_all();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    FILE * file = fopen(output.c_str(), "w");
+    if(!file)
+    {
+        fprintf(stderr, "cannot open %s\n", output.c_str());
+        return 1;
+    }
+    fprintf(file, "match,seed,cyan_goals,magenta_goals,cyan_possession,magenta_possession,"
+                  "cyan_stuck_events,magenta_stuck_events,sim_time,wall_time\n");
+    int wins[2] = {0, 0}, draws = 0;
+    double goals[2] = {0, 0}, possession[2] = {0, 0}, stuck[2] = {0, 0}, sim_time = 0;
+    for(int i=0; i<matches; i++)
+    {
+        const match_result & r = results[i];
+        fprintf(file, "%d,%llu,%d,%d,%.4f,%.4f,%d,%d,%.2f,%.4f\n", i, (unsigned long long)r.seed,
+                r.goals[0], r.goals[1], r.possession[0], r.possession[1],
+                r.stuck_events[0], r.stuck_events[1], r.sim_time, r.wall_time);
+        for(int team=0; team<2; team++)
+        {
+            goals[team] += r.goals[team];
+            possession[team] += r.possession[team];
+            stuck[team] += r.stuck_events[team];
+        }
+        if(r.goals[0] == r.goals[1])
+            draws++;
+        else
+            wins[r.goals[0] > r.goals[1] ? 0 : 1]++;
+        sim_time += r.sim_time;
+    }
+    fclose(file);
+
+    if(matches > 0)
+        printf("%d matches on %d threads in %.2f s (%.0f times real time)\n"
+               "cyan wins %d, magenta wins %d, draws %d\n"
+               "mean goals %.2f : %.2f, possession %.3f : %.3f, stuck events %.2f : %.2f\n"
+               "results written to %s\n",
+               matches, threads, wall, wall > 0 ? sim_time/wall : 0.0, wins[0], wins[1], draws,
+               goals[0]/matches, goals[1]/matches, possession[0]/matches, possession[1]/matches,
+               stuck[0]/matches, stuck[1]/matches, output.c_str());
+    return 0;
+}
@@ -0,0 +1,312 @@
+/* Desc: 2D kinematic simulation with the topics and services of the NubotGazebo plugin.
+ * Usage: roslaunch nubot_gazebo sim2d.launch
+ */
+
+// NOTICE:
+// The simulation uses ISO units, i.e. length uses meters.
+// but other code uses cm as the length unit, so for publishing
+// and subscribing messages, length unit should be changed to 'cm'
+
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include "nubot_sim2d.hh"
+#include "formation.hh"
+
+#define CM2M_CONVERSION 0.01
+
+using namespace gazebo;
+
+NubotSim2D::NubotSim2D()
+{
+    std::string cyan_pre, mag_pre;
+    int cyan_num, mag_num;
+    double field_length, field_width, step_size, ball_decay_coef, clock_rate;
+    nh_.param<std::string>("/cyan/prefix",                  cyan_pre,           std::string("nubot"));
+    nh_.param<std::string>("/magenta/prefix",               mag_pre,            std::string("rival"));
+    nh_.param<int>("/cyan/num",                             cyan_num,           3);
+    nh_.param<int>("/magenta/num",                          mag_num,            3);
+    nh_.param<double>("/field/length",                      field_length,       18.0);
+    nh_.param<double>("/field/width",                       field_width,        12.0);
+    nh_.param<double>("/general/ball_decay_coef",           ball_decay_coef,    0.5);
+    nh_.param<double>("/general/omni_vision_rate",          omni_rate_,         30.0);
+    nh_.param<double>("/general/omni_vision_phase_step",    omni_phase_step_,   0.0);
+    nh_.param<double>("/sim2d/step_size",                   step_size,          0.01);
+    nh_.param<double>("/sim2d/real_time_factor",            real_time_factor_,  0.0);
+    nh_.param<double>("/sim2d/duration",                    duration_,          0.0);
+    nh_.param<double>("/sim2d/clock_rate",                  clock_rate,         100.0);
+
+    world_.configure(field_length, field_width, step_size, ball_decay_coef);
+    clock_scheduler_.configure(clock_rate, 0.0, 0.0);
+    clock_pub_ = nh_.advertise<rosgraph_msgs::Clock>("/clock", 10);
+
+    char name[64];
+    for(int i=1; i<=cyan_num; i++)
+    {
+        snprintf(name, sizeof(name), "%s%d", cyan_pre.c_str(), i);
+        add_robot(name, i, false);
+    }
+    for(int i=1; i<=mag_num; i++)
+    {
+        snprintf(name, sizeof(name), "%s%d", mag_pre.c_str(), i);
+        add_robot(name, i, true);
+    }
+
+    // possession roles as in WorldStateCache; robots first, then the football
+    double dribble_distance_thres, dribble_angle_thres, distance_margin, angle_margin;
+    nh_.param<double>("/general/dribble_distance_thres",    dribble_distance_thres, 0.50);
+    nh_.param<double>("/general/dribble_angle_thres",       dribble_angle_thres,    30.0);
+    nh_.param<double>("/general/possession_distance_margin", distance_margin,       0.05);
+    nh_.param<double>("/general/possession_angle_margin",   angle_margin,           5.0);
+    std::vector<possession_agent> agents(world_.states().size());
+    for(unsigned int i=0; i<agents.size(); i++)
+    {
+        agents[i].robot   = i < robots_.size();
+        agents[i].flipped = agents[i].robot && robots_[i]->flip_cord;
+        agents[i].rank    = agents[i].robot ? agents[i].flipped * 1000 + robots_[i]->agent_id : 0;
+    }
+    possession_.set_agents(agents);
+    possession_.set_params(dribble_distance_thres, dribble_angle_thres, distance_margin, angle_margin);
+
+    // message buffers have a fixed size, as there are no models added or removed
+    for(unsigned int i=0; i<robots_.size(); i++)
+    {
+        for(unsigned int j=0; j<robots_.size(); j++)
+            if(j != i)
+                robots_[i]->obstacles.push_back(j);
+        robots_[i]->omni_info.obstacleinfo.pos.resize(robots_.size() - 1);
+        robots_[i]->omni_info.obstacleinfo.polar_pos.resize(robots_.size() - 1);
+        robots_[i]->omni_info.robotinfo.resize(1);
+    }
+
+    ROS_INFO("NubotSim2D: %d cyan and %d magenta robots on a %.1f x %.1f field; step %.4f s, real time factor %s",
+             cyan_num, mag_num, field_length, field_width, step_size,
+             real_time_factor_ > 0 ? "limited" : "unlimited");
+}
+
+NubotSim2D::~NubotSim2D()
+{
+    for(unsigned int i=0; i<robots_.size(); i++)
+        delete robots_[i];
+}
+
+void NubotSim2D::add_robot(const std::string & name, int agent_id, bool magenta)
+{
+    double noise_scale, noise_rate, stuck_window, stuck_ratio;
+    int noise_seed;
+    nh_.param<double>("/general/noise_scale",               noise_scale,            0.10);
+    nh_.param<double>("/general/noise_rate",                noise_rate,             0.01);
+    nh_.param<int>("/general/noise_seed",                   noise_seed,             0);
+    nh_.param<double>("/general/stuck_window",              stuck_window,           0.6);
+    nh_.param<double>("/general/stuck_ratio",               stuck_ratio,            0.9);
+
+    // robot_up.sh positions; others start in a row at the side line
+    double x, y;
+    if(!formation_position(magenta, agent_id, x, y))
+    {
+        x = (magenta ? 1 : -1) * 0.6 * agent_id;
+        y = -world_.field_width()/2.0;
+    }
+    unsigned int index = world_.add_robot(x, y, 0.0);
+
+    sim2d_robot * robot = new sim2d_robot(&world_, index);
+    robot->name = name;
+    robot->agent_id = agent_id;
+    robot->flip_cord = magenta;
+
+    // the same noise streams as NubotGazebo on field 0: team (CYAN_TEAM 0, MAGENTA_TEAM 1) * 1000 + id
+    uint64_t seed = noise_seed != 0 ? (uint64_t)(unsigned int)noise_seed : NoiseGenerator::default_seed();
+    double step_size = world_.step_size();
+    robot->behaviour.configure(magenta, seed, (magenta ? 1 : 0) * 1000 + agent_id,
+                               stuck_window, (unsigned int)ceil(stuck_window / std::max(step_size, 1e-4)) + 2, stuck_ratio);
+    robot->behaviour.set_params(noise_scale, noise_rate);
+    const double goal_x = world_.field_length() / 2.0;
+    robot->behaviour.set_goals(-goal_x, 0.0, goal_x, 0.0);
+    robot->omni_scheduler.configure(omni_rate_, omni_phase_step_ * index, 0.0);     // one slot per robot of both teams
+
+    ros::NodeHandle rosnode(name);
+    robot->omni_vision_pub = rosnode.advertise<nubot_common::OminiVisionInfo>("omnivision/OmniVisionInfo", 10);
+    robot->odo_info_pub    = rosnode.advertise<nubot_common::OdoInfo>("nubotdriver/odoinfo", 10);
+    robot->velcmd_sub      = rosnode.subscribe<nubot_common::VelCmd>("nubotcontrol/velcmd", 100,
+                                 boost::bind(&NubotSim2D::vel_cmd_CB, this, _1, index));
+    robot->actuator_sub    = rosnode.subscribe<nubot_common::ActuatorCmd>("nubotcontrol/actuator", 100,
+                                 boost::bind(&NubotSim2D::actuator_CB, this, _1, index));
+    robot->actuator_state_pub = rosnode.advertise<nubot_common::ActuatorState>("nubotcontrol/actuator_state", 10);
+    robot->ballhandle_server = rosnode.advertiseService<nubot_common::BallHandle::Request, nubot_common::BallHandle::Response>(
+                                 "BallHandle", boost::bind(&NubotSim2D::ball_handle_control_service, this, _1, _2, index));
+    robot->shoot_server      = rosnode.advertiseService<nubot_common::Shoot::Request, nubot_common::Shoot::Response>(
+                                 "Shoot", boost::bind(&NubotSim2D::shoot_control_servive, this, _1, _2, index));
+    robots_.push_back(robot);
+}
+
+void NubotSim2D::run(void)
+{
+    ros::WallTime start = ros::WallTime::now();
+    while(ros::ok() && (duration_ <= 0.0 || world_.sim_time() < duration_))
+    {
+        ros::spinOnce();                    // commands and service requests of the last step
+        step();
+
+        if(clock_scheduler_.should_publish(world_.sim_time()))
+        {
+            rosgraph_msgs::Clock clock;
+            clock.clock.fromSec(world_.sim_time());
+            clock_pub_.publish(clock);
+        }
+
+        if(real_time_factor_ > 0.0)
+        {
+            ros::WallTime target = start + ros::WallDuration(world_.sim_time() / real_time_factor_);
+            ros::WallDuration ahead = target - ros::WallTime::now();
+            if(ahead > ros::WallDuration(0.0))
+                ahead.sleep();
+        }
+    }
+
+    double wall = (ros::WallTime::now() - start).toSec();
+    ROS_INFO("NubotSim2D: %.1f s simulated in %.3f s (%.0f times real time), %lu steps",
+             world_.sim_time(), wall, wall > 0 ? world_.sim_time()/wall : 0.0, world_.iterations());
+}
+
+void NubotSim2D::step(void)
+{
+    const PlanarStates & states = world_.states();
+    const int ball = world_.ball_index();
+    transform_ball_to_egos(states, ball, ball_relative_);
+    possession_.update(ball_relative_);
+    for(unsigned int i=0; i<robots_.size(); i++)
+    {
+        sim2d_robot & robot = *robots_[i];
+        robot.behaviour.update(states, world_.iterations(), world_.sim_time(), i, ball, robot.backend);
+
+        if(robot.new_vel_cmd)
+        {
+            robot.behaviour.move(robot.Vx, robot.Vy, robot.w, robot.backend);
+            robot.new_vel_cmd = false;
+        }
+        if(robot.dribble && holds_ball(i))                      // dribble is set by BallHandle service
+            robot.behaviour.dribble_ball(robot.backend);
+        if(robot.shoot)
+        {
+            robot.behaviour.kick_ball(robot.mode, robot.force, robot.backend);
+            robot.shoot = false;
+        }
+        publish_actuator_state(robot, i);
+
+        if(robot.omni_scheduler.should_publish(world_.sim_time()))
+            publish(robot, i);
+    }
+    world_.step();
+
+    // no goal model to hold the ball; the referee puts it back to the center
+    if(world_.goal())
+    {
+        ROS_INFO("NubotSim2D: goal at %s x, %.1f s", world_.goal() > 0 ? "+" : "-", world_.sim_time());
+        world_.place_ball(0.0, 0.0);
+        possession_.reset();
+    }
+}
+
+void NubotSim2D::publish(sim2d_robot & robot, unsigned int index)
+{
+    ros::Time now;
+    now.fromSec(world_.sim_time());
+    const agent_state & self = robot.behaviour.robot();
+    robot_message_state state;
+    state.agent_id  = robot.agent_id;
+    state.valid     = in_field(self.x, self.y);
+    state.hold_ball = holds_ball(index);
+    fill_robot_messages(robot.behaviour, robot.obstacles, state, now, robot.omni_info, robot.odo_info);
+    robot.omni_vision_pub.publish(robot.omni_info);
+    robot.odo_info_pub.publish(robot.odo_info);
+}
+
+void NubotSim2D::publish_actuator_state(sim2d_robot & robot, unsigned int index)
+{
+    if(!robot.actuator_state_pub.getNumSubscribers())
+        return;
+    nubot_common::ActuatorState & state = robot.actuator_state;
+    state.header.stamp.fromSec(world_.sim_time());
+    state.header.seq++;
+    state.BallIsHolding = holds_ball(index);
+    state.RobotStuck = robot.behaviour.stuck();
+    robot.actuator_state_pub.publish(state);
+}
+
+void NubotSim2D::vel_cmd_CB(const nubot_common::VelCmd::ConstPtr & cmd, unsigned int index)
+{
+    sim2d_robot & robot = *robots_[index];
+    double sign = robot.flip_cord ? -1.0 : 1.0;
+    robot.Vx = sign * cmd->Vx * CM2M_CONVERSION;
+    robot.Vy = sign * cmd->Vy * CM2M_CONVERSION;
+    robot.w  = cmd->w;
+    robot.new_vel_cmd = true;
+}
+
+void NubotSim2D::actuator_CB(const nubot_common::ActuatorCmd::ConstPtr & cmd, unsigned int index)
+{
+    // as NubotGazebo::actuator_CB(): one velocity command, one BallHandle and maybe one Shoot request
+    nubot_common::VelCmd::Ptr vel(new nubot_common::VelCmd(cmd->vel));
+    vel_cmd_CB(vel, index);
+
+    nubot_common::BallHandle::Request  ball_handle_req;
+    nubot_common::BallHandle::Response ball_handle_res;
+    ball_handle_req.enable = cmd->dribble;
+    ball_handle_control_service(ball_handle_req, ball_handle_res, index);
+
+    if(cmd->shoot)
+    {
+        nubot_common::Shoot::Request  shoot_req;
+        nubot_common::Shoot::Response shoot_res;
+        shoot_req.strength = cmd->strength;
+        shoot_req.ShootPos = cmd->ShootPos;
+        shoot_control_servive(shoot_req, shoot_res, index);
+    }
+    robots_[index]->actuator_state.seq = cmd->seq;
+}
+
+bool NubotSim2D::ball_handle_control_service(nubot_common::BallHandle::Request & req,
+                                             nubot_common::BallHandle::Response & res, unsigned int index)
+{
+    sim2d_robot & robot = *robots_[index];
+    bool is_hold_ball = holds_ball(index);
+
+    // as NubotGazebo::ball_handle_control_service()
+    robot.dribble = req.enable && is_hold_ball;
+    res.BallIsHolding = is_hold_ball;
+    return true;
+}
+
+bool NubotSim2D::shoot_control_servive(nubot_common::Shoot::Request & req,
+                                       nubot_common::Shoot::Response & res, unsigned int index)
+{
+    sim2d_robot & robot = *robots_[index];
+    bool is_hold_ball = holds_ball(index);
+
+    // as NubotGazebo::shoot_control_servive()
+    robot.force = std::min((double)req.strength, 15.0);
+    robot.mode  = (int)req.ShootPos;
+    if(robot.force)
+    {
+        robot.shoot = is_hold_ball;
+        if(is_hold_ball)
+            robot.dribble = false;
+        res.ShootIsDone = is_hold_ball;
+    }
+    else
+    {
+        robot.shoot = false;
+        res.ShootIsDone = 1;
+    }
+    robot.actuator_state.ShootIsDone = res.ShootIsDone;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "nubot_sim2d");
+    gazebo::NubotSim2D sim;
+    sim.run();
+    return 0;
+}
@@ -0,0 +1,114 @@
+#ifndef NUBOT_SIM2D_HH
+#define NUBOT_SIM2D_HH
+
+#include <ros/ros.h>
+#include <rosgraph_msgs/Clock.h>
+#include "nubot_common/OminiVisionInfo.h"
+#include "nubot_common/VelCmd.h"
+#include "nubot_common/OdoInfo.h"
+#include "nubot_common/Shoot.h"
+#include "nubot_common/BallHandle.h"
+#include "nubot_common/ActuatorCmd.h"
+#include "nubot_common/ActuatorState.h"
+
+#include <string>
+#include <vector>
+
+#include "kinematic_world.hh"
+#include "robot_behaviour.hh"
+#include "robot_messages.hh"
+#include "ball_possession.hh"
+#include "publish_scheduler.hh"
+
+namespace gazebo{
+   /// \brief One robot of the 2D simulation with its ROS interface
+   struct sim2d_robot
+   {
+       std::string                     name;
+       int                             agent_id;
+       bool                            flip_cord;          // magenta (rival) robot
+       RobotBehaviour                  behaviour;
+       KinematicRobot                  backend;
+       PublishScheduler                omni_scheduler;
+
+       ros::Subscriber                 velcmd_sub;
+       ros::Subscriber                 actuator_sub;
+       ros::Publisher                  actuator_state_pub;
+       ros::Publisher                  omni_vision_pub;
+       ros::Publisher                  odo_info_pub;
+       ros::ServiceServer              ballhandle_server;
+       ros::ServiceServer              shoot_server;
+       nubot_common::OminiVisionInfo   omni_info;          // filled in place
+       nubot_common::OdoInfo           odo_info;
+       std::vector<int>                obstacles;          // indices of the other robots, as in omni_info
+       nubot_common::ActuatorState     actuator_state;     // seq and ShootIsDone are set by the callbacks
+
+       double                          Vx, Vy, w;          // latest velocity command; m/s, coordinate frame already flipped
+       bool                            new_vel_cmd;        // not applied yet
+       bool                            dribble;            // BallHandle enabled and robot is able to dribble
+       bool                            shoot;              // a Shoot request is to be executed
+       double                          force;              // kick ball force
+       int                             mode;               // kick ball mode
+
+       sim2d_robot(KinematicWorld * world, unsigned int index)
+           : agent_id(0), flip_cord(false), backend(world, index),
+             Vx(0), Vy(0), w(0), new_vel_cmd(false), dribble(false), shoot(false), force(0), mode(RUN)
+       {}
+   };
+
+  /// \class NubotSim2D
+  /// \brief Faster-than-real-time replacement of the Gazebo world for strategy evaluation.
+  /// Robots and the football live in a KinematicWorld and behave as in NubotGazebo (the same
+  /// RobotBehaviour); every robot has the topics and services of NubotGazebo. Callbacks run in
+  /// the simulation thread between steps, so commands take effect in the next step.
+  class NubotSim2D
+  {
+    public:
+        NubotSim2D();
+        ~NubotSim2D();
+
+        /// \brief Run the simulation until ROS shuts down or the configured duration has passed
+        void run(void);
+
+    private:
+        /// \brief Add a robot with its ROS interface
+        /// \param[in] name         model name, e.g. nubot1
+        /// \param[in] agent_id     robot id
+        /// \param[in] magenta      rival robot; its coordinate frame is flipped
+        void add_robot(const std::string & name, int agent_id, bool magenta);
+
+        /// \brief Advance by one step: behaviour of all robots, then the world
+        void step(void);
+
+        /// \brief Fill and publish OmniVisionInfo and odometry of a robot
+        void publish(sim2d_robot & robot, unsigned int index);
+
+        /// \brief Publish the actuator state of a robot if anyone listens
+        void publish_actuator_state(sim2d_robot & robot, unsigned int index);
+
+        /// \brief Whether robot i holds the ball in this step
+        bool holds_ball(unsigned int index) const { return possession_.holder() == (int)index; }
+
+        void vel_cmd_CB(const nubot_common::VelCmd::ConstPtr & cmd, unsigned int index);
+        void actuator_CB(const nubot_common::ActuatorCmd::ConstPtr & cmd, unsigned int index);
+        bool ball_handle_control_service(nubot_common::BallHandle::Request & req,
+                                         nubot_common::BallHandle::Response & res, unsigned int index);
+        bool shoot_control_servive(nubot_common::Shoot::Request & req,
+                                   nubot_common::Shoot::Response & res, unsigned int index);
+
+        ros::NodeHandle                 nh_;
+        ros::Publisher                  clock_pub_;
+        PublishScheduler                clock_scheduler_;   // /clock is published at a fixed rate of simulated time
+        KinematicWorld                  world_;
+        std::vector<sim2d_robot*>       robots_;            // entry i is robot i of world_
+        BallPossession                  possession_;        // who holds the ball, decided once per step
+        EgoStates                       ball_relative_;     // football relative to every agent
+
+        double                          real_time_factor_;  // <= 0 runs as fast as possible
+        double                          duration_;          // simulated seconds to run; <= 0 runs until shutdown
+        double                          omni_rate_;
+        double                          omni_phase_step_;
+  };
+}
+
+#endif //! NUBOT_SIM2D_HH
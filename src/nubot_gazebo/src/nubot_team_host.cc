@@ -0,0 +1,293 @@
+/* Desc: runs the behaviours of all robots of one team in one process.
+ * Usage: rosrun nubot_gazebo nubot_team_host _team:=cyan [_rate:=50] [_threads:=2] [_timeout:=0.5]
+ *        [_behaviour:=chase_dribble] [_behaviour2:=NAME] [_libraries:="[lib.so, ...]"]
+ */
+
+// NOTICE:
+// Behaviours use ISO units, i.e. length uses meters.
+// but the messages use cm as the length unit
+
+#include <ros/callback_queue.h>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "nubot_team_host.hh"
+#include "planar_angle.hh"
+
+#define CM2M_CONVERSION 0.01
+#define M2CM_CONVERSION 100
+
+using namespace gazebo;
+
+NubotTeamHost::NubotTeamHost()
+    : nh_("~"), magenta_(false), field_length_(18.0), rate_(50.0), timeout_(0.5), decided_seq_(0), stopped_(false),
+      cycle_(0), busy_workers_(0), stop_(false), next_robot_(0)
+{
+    std::string team;
+    int threads;
+    nh_.param<std::string>("team",                      team,               std::string("cyan"));
+    nh_.param<double>("rate",                           rate_,              50.0);
+    nh_.param<int>("threads",                           threads,            2);
+    nh_.param<double>("timeout",                        timeout_,           0.5);
+    nh_.param<std::string>("behaviour",                 default_behaviour_, std::string("chase_dribble"));
+    magenta_ = team == "magenta";
+
+    // the field's own size overrides the global one, as in NubotGazebo
+    ros::NodeHandle global;
+    global.param<double>("/field/length",               field_length_,      field_length_);
+    global.param<double>("field/length",                field_length_,      field_length_);
+    global.param<std::string>(magenta_ ? "/magenta/prefix" : "/cyan/prefix", prefix_,
+                              std::string(magenta_ ? "rival" : "nubot"));
+
+    std::vector<std::string> libraries;
+    nh_.getParam("libraries", libraries);
+    for(unsigned int i=0; i<libraries.size(); i++)
+    {
+        std::string error;
+        if(!BehaviourRegistry::Instance()->load(libraries[i], error))
+            ROS_ERROR("NubotTeamHost: cannot load %s: %s", libraries[i].c_str(), error.c_str());
+    }
+
+    team_nh_ = ros::NodeHandle(magenta_ ? "magenta" : "cyan");
+    world_model_sub_ = team_nh_.subscribe("worldmodel/WorldModelInfo", 1, &NubotTeamHost::world_model_CB, this);
+    actuator_pub_ = team_nh_.advertise<nubot_common::TeamActuatorCmd>("teamcontrol/actuator", 10);
+
+    // the calling thread takes part in every cycle, so one thread needs no worker
+    for(int i=1; i<threads; i++)
+        workers_.create_thread(boost::bind(&NubotTeamHost::worker, this));
+    snapshot_.cycle = 0;
+    ROS_INFO("NubotTeamHost: %s at %.1f Hz on %d threads, default behaviour %s",
+             team_nh_.getNamespace().c_str(), rate_, threads > 1 ? threads : 1, default_behaviour_.c_str());
+}
+
+NubotTeamHost::~NubotTeamHost()
+{
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        stop_ = true;
+    }
+    start_cond_.notify_all();
+    workers_.join_all();
+    for(std::map<int, TeamBehaviour*>::iterator it = behaviours_.begin(); it != behaviours_.end(); ++it)
+        delete it->second;
+}
+
+void NubotTeamHost::world_model_CB(const nubot_common::WorldModelInfo::ConstPtr & msg)
+{
+    world_model_ = msg;
+    received_ = ros::WallTime::now();
+}
+
+TeamBehaviour* NubotTeamHost::behaviour(int agent_id)
+{
+    std::map<int, TeamBehaviour*>::iterator it = behaviours_.find(agent_id);
+    if(it != behaviours_.end())
+        return it->second;
+
+    // ~behaviour<id> chooses the behaviour of one robot
+    char key[32];
+    snprintf(key, sizeof(key), "behaviour%d", agent_id);
+    std::string name;
+    nh_.param<std::string>(key, name, default_behaviour_);
+    TeamBehaviour* behaviour = BehaviourRegistry::Instance()->create(name);
+    if(behaviour)
+    {
+        behaviour->configure(agent_id, magenta_);
+        ROS_INFO("NubotTeamHost: %s%d runs %s", prefix_.c_str(), agent_id, name.c_str());
+    }
+    else
+        ROS_ERROR("NubotTeamHost: no behaviour %s for %s%d", name.c_str(), prefix_.c_str(), agent_id);
+    behaviours_[agent_id] = behaviour;
+    return behaviour;
+}
+
+bool NubotTeamHost::build_snapshot(void)
+{
+    if(!world_model_ || world_model_->ballinfo.empty())
+        return false;
+    const nubot_common::WorldModelInfo & world_model = *world_model_;
+
+    // every world model is decided on once, and at most rate_ of them per second of simulated time,
+    // measured on their stamps; a restarted gzserver starts over with earlier stamps
+    const double since = (world_model.header.stamp - decided_stamp_).toSec();
+    if(snapshot_.cycle > 0 && since >= 0.0 && since < 1.0 / rate_ - 1e-4)
+        return false;
+    decided_seq_   = world_model.header.seq;
+    decided_stamp_ = world_model.header.stamp;
+
+    // team frame as in WorldModelInfo; the attacked goal is at +x
+    snapshot_.cycle++;
+    snapshot_.time = world_model.header.stamp.toSec();
+    const nubot_common::BallInfo & ball = world_model.ballinfo[0];
+    snapshot_.ball_x  = ball.pos.x * CM2M_CONVERSION;
+    snapshot_.ball_y  = ball.pos.y * CM2M_CONVERSION;
+    snapshot_.ball_vx = ball.velocity.x * CM2M_CONVERSION;
+    snapshot_.ball_vy = ball.velocity.y * CM2M_CONVERSION;
+    const double goal_x = field_length_ / 2.0;
+
+    const unsigned int n = world_model.robotinfo.size();
+    snapshot_.robots.resize(n);
+    cycle_behaviours_.resize(n);
+    for(unsigned int i=0; i<n; i++)
+    {
+        const nubot_common::RobotInfo & info = world_model.robotinfo[i];
+        robot_view & robot = snapshot_.robots[i];
+        robot.agent_id = info.AgentID;
+        robot.x   = info.pos.x * CM2M_CONVERSION;
+        robot.y   = info.pos.y * CM2M_CONVERSION;
+        robot.yaw = info.heading.theta;
+        robot.vx  = info.vtrans.x * CM2M_CONVERSION;
+        robot.vy  = info.vtrans.y * CM2M_CONVERSION;
+        robot.w   = info.vrot;
+        robot.valid   = info.isvalid;
+        robot.stuck   = info.isstuck;
+        robot.holding = info.isdribble;
+
+        // the ego quantities of OmniVisionInfo, without its perception noise
+        const double c = std::cos(robot.yaw), s = std::sin(robot.yaw);
+        double dx = snapshot_.ball_x - robot.x, dy = snapshot_.ball_y - robot.y;
+        robot.ball_range   = std::sqrt(dx*dx + dy*dy);
+        robot.ball_bearing = planar_angle(c, s, dx, dy);
+        dx = -goal_x - robot.x;
+        dy = -robot.y;
+        robot.left_goal_range   = std::sqrt(dx*dx + dy*dy);
+        robot.left_goal_bearing = planar_angle(c, s, dx, dy);
+        dx = goal_x - robot.x;
+        robot.right_goal_range   = std::sqrt(dx*dx + dy*dy);
+        robot.right_goal_bearing = planar_angle(c, s, dx, dy);
+
+        cycle_behaviours_[i] = behaviour(robot.agent_id);
+    }
+
+    const unsigned int opponent_num = world_model.oppinfo.pos.size();
+    snapshot_.opponent_x.resize(opponent_num);
+    snapshot_.opponent_y.resize(opponent_num);
+    for(unsigned int i=0; i<opponent_num; i++)
+    {
+        snapshot_.opponent_x[i] = world_model.oppinfo.pos[i].x * CM2M_CONVERSION;
+        snapshot_.opponent_y[i] = world_model.oppinfo.pos[i].y * CM2M_CONVERSION;
+    }
+    return true;
+}
+
+void NubotTeamHost::run_behaviours(void)
+{
+    // every robot writes only its own entry of commands_, so the result does not depend on the threads
+    const unsigned int n = snapshot_.robots.size();
+    unsigned int i;
+    while((i = next_robot_.fetch_add(1)) < n)
+        if(cycle_behaviours_[i])
+            commands_[i] = cycle_behaviours_[i]->on_perception(snapshot_, i);
+}
+
+void NubotTeamHost::worker(void)
+{
+    uint64_t seen = 0;
+    while(true)
+    {
+        {
+            boost::mutex::scoped_lock lock(lock_);
+            while(cycle_ == seen && !stop_)
+                start_cond_.wait(lock);
+            if(stop_)
+                return;
+            seen = cycle_;
+        }
+        run_behaviours();
+        boost::mutex::scoped_lock lock(lock_);
+        if(--busy_workers_ == 0)
+            done_cond_.notify_one();
+    }
+}
+
+void NubotTeamHost::run_cycle(void)
+{
+    commands_.assign(snapshot_.robots.size(), actuator_command());
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        next_robot_.store(0);
+        busy_workers_ = workers_.size();
+        cycle_++;
+    }
+    start_cond_.notify_all();
+    run_behaviours();
+
+    boost::mutex::scoped_lock lock(lock_);
+    while(busy_workers_ > 0)
+        done_cond_.wait(lock);
+}
+
+void NubotTeamHost::publish(void)
+{
+    const unsigned int n = snapshot_.robots.size();
+    team_cmd_.commands.resize(n);
+    char name[64];
+    for(unsigned int i=0; i<n; i++)
+    {
+        const actuator_command & cmd = commands_[i];
+        nubot_common::ActuatorCmd & out = team_cmd_.commands[i];
+        snprintf(name, sizeof(name), "%s%d", prefix_.c_str(), snapshot_.robots[i].agent_id);
+        out.robot    = name;
+        out.seq      = (uint32_t)snapshot_.cycle;
+        out.vel.Vx   = cmd.Vx * M2CM_CONVERSION;
+        out.vel.Vy   = cmd.Vy * M2CM_CONVERSION;
+        out.vel.w    = cmd.w;
+        out.dribble  = cmd.dribble;
+        out.shoot    = cmd.shoot;
+        out.strength = cmd.strength;
+        out.ShootPos = cmd.shoot_pos;
+    }
+    team_cmd_.header.stamp = ros::Time::now();
+    team_cmd_.header.seq++;
+    actuator_pub_.publish(team_cmd_);
+}
+
+void NubotTeamHost::stop_robots(void)
+{
+    // the plugins keep applying the last velocity command, so it is overwritten rather than left to age
+    commands_.assign(snapshot_.robots.size(), actuator_command());
+    publish();
+}
+
+void NubotTeamHost::run(void)
+{
+    typedef std::chrono::steady_clock clock;
+    const double period = 1.0 / rate_;
+
+    // waits on wall time, not on /clock, which stops when gzserver pauses or dies; a new world
+    // model wakes the loop at once
+    ros::CallbackQueue * queue = ros::getGlobalCallbackQueue();
+    const ros::WallDuration wait(std::min(period, timeout_ / 4.0));
+    while(ros::ok())
+    {
+        queue->callAvailable(wait);
+        if(build_snapshot())
+        {
+            clock::time_point start = clock::now();
+            run_cycle();
+            publish();
+            const double busy = std::chrono::duration<double>(clock::now() - start).count();
+            if(busy > period)
+                ROS_WARN_THROTTLE(5.0, "NubotTeamHost: cycle %llu took %.1f ms, more than the period of %.1f ms",
+                                  (unsigned long long)snapshot_.cycle, busy * 1e3, period * 1e3);
+            stopped_ = false;
+        }
+        else if(snapshot_.cycle > 0 && !stopped_ && (ros::WallTime::now() - received_).toSec() > timeout_)
+        {
+            ROS_WARN("NubotTeamHost: no new world model for %.1f s, stopping the robots", timeout_);
+            stop_robots();
+            stopped_ = true;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ros::init(argc, argv, "nubot_team_host");
+    gazebo::NubotTeamHost host;
+    host.run();
+    return 0;
+}
@@ -0,0 +1,99 @@
+#ifndef NUBOT_TEAM_HOST_HH
+#define NUBOT_TEAM_HOST_HH
+
+#include <ros/ros.h>
+#include "nubot_common/WorldModelInfo.h"
+#include "nubot_common/TeamActuatorCmd.h"
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <atomic>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "team_behaviour.hh"
+
+namespace gazebo{
+  /// \class NubotTeamHost
+  /// \brief Runs the behaviours of all robots of one team in one process, in place of one
+  /// strategy.py loop per robot. Every new WorldModelInfo of the team, at most a fixed number per
+  /// second of simulated time, starts a control cycle: it is turned into a team_snapshot, the
+  /// behaviours of all robots decide on the same snapshot, concurrently on a small pool of threads, and their commands
+  /// go out together in one TeamActuatorCmd on <team>/teamcontrol/actuator, which every NubotGazebo
+  /// of the team subscribes to. Behaviours are chosen per robot by name, see BehaviourRegistry.
+  /// If no new world model arrives for a timeout of wall time, e.g. because gzserver paused or died,
+  /// the robots are stopped once and nothing more is published until one arrives.
+  class NubotTeamHost
+  {
+    public:
+        NubotTeamHost();
+        ~NubotTeamHost();
+
+        /// \brief Run the control cycles until ROS shuts down
+        void run(void);
+
+    private:
+        void world_model_CB(const nubot_common::WorldModelInfo::ConstPtr & msg);
+
+        /// \brief Fill snapshot_ from the latest world model and find the behaviour of every robot
+        /// \return false if there is no world model to decide on: none yet, or the latest one was
+        /// decided on already or came less than a cycle period after it
+        bool build_snapshot(void);
+
+        /// \brief Behaviour of a robot, created on first use
+        /// \return NULL if its behaviour is not registered
+        TeamBehaviour* behaviour(int agent_id);
+
+        /// \brief Decide the commands of all robots on snapshot_; the calling thread joins the workers
+        void run_cycle(void);
+
+        /// \brief Take robots from next_robot_ until none is left
+        void run_behaviours(void);
+
+        /// \brief Worker thread
+        void worker(void);
+
+        /// \brief Fill and publish the TeamActuatorCmd of this cycle
+        void publish(void);
+
+        /// \brief Publish zero commands for the robots of the last cycle
+        void stop_robots(void);
+
+        ros::NodeHandle                 nh_;
+        ros::NodeHandle                 team_nh_;           // <team>, in the field's namespace if there is one
+        ros::Subscriber                 world_model_sub_;
+        ros::Publisher                  actuator_pub_;
+
+        bool                            magenta_;
+        std::string                     prefix_;            // robot model name prefix of the team
+        std::string                     default_behaviour_;
+        double                          field_length_;      // m
+        double                          rate_;              // most control cycles per second of simulated time
+        double                          timeout_;           // s of wall time without a new world model before the robots are stopped
+
+        nubot_common::WorldModelInfo::ConstPtr world_model_;    // latest; ROS callbacks run in run()
+        ros::WallTime                   received_;          // when world_model_ arrived
+        uint32_t                        decided_seq_;       // header of the last world model a cycle decided on
+        ros::Time                       decided_stamp_;
+        bool                            stopped_;           // robots stopped after a timeout; quiet until a new world model
+        std::map<int, TeamBehaviour*>   behaviours_;        // by agent id
+        std::vector<TeamBehaviour*>     cycle_behaviours_;  // of snapshot_.robots
+        team_snapshot                   snapshot_;
+        std::vector<actuator_command>   commands_;          // of snapshot_.robots
+        nubot_common::TeamActuatorCmd   team_cmd_;          // filled in place
+
+        boost::thread_group             workers_;
+        boost::mutex                    lock_;
+        boost::condition_variable       start_cond_;        // a cycle has started
+        boost::condition_variable       done_cond_;         // the last worker has finished its robots
+        uint64_t                        cycle_;             // last started cycle
+        int                             busy_workers_;      // workers not done with the current cycle
+        bool                            stop_;
+        std::atomic<unsigned int>       next_robot_;
+  };
+}
+
+#endif //! NUBOT_TEAM_HOST_HH
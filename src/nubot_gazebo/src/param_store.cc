@@ -0,0 +1,68 @@
+#include "param_store.hh"
+
+#include <boost/bind.hpp>
+
+using namespace gazebo;
+
+ParamStore*     ParamStore::instance_ = NULL;
+boost::mutex    ParamStore::instance_lock_;
+
+ParamStore* ParamStore::Instance(void)
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    if(!instance_)
+        instance_ = new ParamStore();
+    return instance_;
+}
+
+ParamStore::ParamStore()
+{
+    int callback_threads;
+    rosnode_.param<int>("/general/callback_threads", callback_threads, 2);
+    queue_ = CallbackExecutor::Instance(callback_threads)->create_queue();
+
+    ros::SubscribeOptions so = ros::SubscribeOptions::create<dynamic_reconfigure::Config>(
+                "/general/param_updates", 10, boost::bind(&ParamStore::param_updates_CB, this, _1),
+                ros::VoidPtr(), queue_.get());
+    param_updates_sub_ = rosnode_.subscribe(so);
+}
+
+const ParamValue* ParamStore::declare(const std::string & name, double default_value)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    std::map<std::string, ParamValue*>::iterator it = index_.find(name);
+    if(it != index_.end())
+        return it->second;
+
+    double value;
+    rosnode_.param<double>(name, value, default_value);
+    values_.emplace_back(value);
+    index_[name] = &values_.back();
+    return &values_.back();
+}
+
+void ParamStore::update(const std::string & name, double value)
+{
+    {
+        boost::mutex::scoped_lock lock(lock_);
+        std::map<std::string, ParamValue*>::iterator it = index_.find(name);
+        if(it == index_.end())
+        {
+            ROS_WARN("ParamStore: ignoring update of unknown parameter %s", name.c_str());
+            return;
+        }
+        it->second->set(value);
+    }
+    rosnode_.setParam(name, value);
+    ROS_INFO("ParamStore: %s = %f", name.c_str(), value);
+}
+
+void ParamStore::param_updates_CB(const dynamic_reconfigure::Config::ConstPtr & config)
+{
+    for(unsigned int i=0; i<config->doubles.size(); i++)
+        update(config->doubles[i].name, config->doubles[i].value);
+    for(unsigned int i=0; i<config->ints.size(); i++)
+        update(config->ints[i].name, config->ints[i].value);
+    for(unsigned int i=0; i<config->bools.size(); i++)
+        update(config->bools[i].name, config->bools[i].value ? 1.0 : 0.0);
+}
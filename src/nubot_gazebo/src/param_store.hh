@@ -0,0 +1,73 @@
+#ifndef PARAM_STORE_HH
+#define PARAM_STORE_HH
+
+#include <ros/ros.h>
+#include <dynamic_reconfigure/Config.h>
+
+#include "callback_executor.hh"
+
+#include <boost/thread/mutex.hpp>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string>
+
+namespace gazebo{
+  /// \brief A parameter value shared between the ROS callback threads and the physics thread
+  class ParamValue
+  {
+    public:
+        explicit ParamValue(double value) : value_(value) {}
+
+        /// \brief Current value; a single atomic load, safe to call every physics step
+        double get(void) const { return value_.load(std::memory_order_relaxed); }
+
+        void set(double value) { value_.store(value, std::memory_order_relaxed); }
+
+    private:
+        std::atomic<double> value_;
+  };
+
+  /// \class ParamStore
+  /// \brief Parameters of all plugins in the gzserver process. Each parameter is read from the
+  /// parameter server once when declared; later changes arrive on the topic
+  /// /general/param_updates (dynamic_reconfigure/Config, matched by full parameter name) and are
+  /// handed to the update loops atomically, so no plugin queries the ROS master from the physics thread.
+  /// Example:
+  ///     rostopic pub -1 /general/param_updates dynamic_reconfigure/Config \
+  ///         '{doubles: [{name: /general/ball_decay_coef, value: 0.3}]}'
+  class ParamStore
+  {
+    public:
+        /// \brief Get the process-wide store. It is created by the first caller.
+        static ParamStore* Instance(void);
+
+        /// \brief Declare a parameter, reading its value from the parameter server. Declaring the
+        /// same name again returns the same value. Called at load time.
+        /// \param[in] name           full parameter name, e.g. "/general/ball_decay_coef"
+        /// \param[in] default_value  value if the parameter is not set
+        /// \return the shared value; valid for the lifetime of the process
+        const ParamValue* declare(const std::string & name, double default_value);
+
+    private:
+        ParamStore();
+
+        /// \brief Update known parameters; runs on a callback thread
+        void param_updates_CB(const dynamic_reconfigure::Config::ConstPtr & config);
+
+        /// \brief Set a known parameter and mirror it to the parameter server
+        void update(const std::string & name, double value);
+
+        static ParamStore*          instance_;
+        static boost::mutex         instance_lock_;
+
+        ros::NodeHandle             rosnode_;
+        ros::Subscriber             param_updates_sub_;
+        StrandQueuePtr              queue_;
+        boost::mutex                lock_;              // guards index_ and values_ against declare()
+        std::map<std::string, ParamValue*> index_;
+        std::deque<ParamValue>      values_;            // a deque never moves its elements
+  };
+}
+
+#endif //! PARAM_STORE_HH
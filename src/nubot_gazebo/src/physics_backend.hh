@@ -0,0 +1,33 @@
+#ifndef PHYSICS_BACKEND_HH
+#define PHYSICS_BACKEND_HH
+
+namespace gazebo{
+  /// \class PhysicsBackend
+  /// \brief What RobotBehaviour needs from a physics engine to act on one robot and the football.
+  /// All values are in the world frame and in ISO units (m, m/s, rad/s). Implemented by
+  /// NubotGazebo on top of physics::Model, and by cheaper engines for bulk simulation.
+  class PhysicsBackend
+  {
+    public:
+        virtual ~PhysicsBackend() {}
+
+        /// \brief Set the planar velocity of the robot
+        /// \param[in] vx,vy    linear velocity (m/s)
+        /// \param[in] w        angular velocity around z (rad/s)
+        virtual void set_robot_velocity(double vx, double vy, double w) = 0;
+
+        /// \brief Height of the robot's origin above the ground (m); tells whether it is in the air
+        virtual double robot_height(void) const = 0;
+
+        /// \brief Place the football and stop it
+        /// \param[in] x,y,z    position (m)
+        /// \param[in] yaw      orientation around z (rad)
+        virtual void set_ball_pose(double x, double y, double z, double yaw) = 0;
+
+        /// \brief Set the linear velocity of the football
+        /// \param[in] vx,vy,vz linear velocity (m/s)
+        virtual void set_ball_velocity(double vx, double vy, double vz) = 0;
+  };
+}
+
+#endif //! PHYSICS_BACKEND_HH
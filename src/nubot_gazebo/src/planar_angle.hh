@@ -0,0 +1,87 @@
+/* Desc: Planar angle kernels replacing the normalize/dot/cross/acos chain of vector_angle.hh
+ *       for vectors in the x-y plane. Gazebo-free; point sets in nubot/core/PointArray.hpp.
+ */
+
+#ifndef PLANAR_ANGLE_HH
+#define PLANAR_ANGLE_HH
+
+#include <nubot/core/PointArray.hpp>
+#include <cmath>
+
+namespace gazebo{
+   /// \brief atan2 from a minimax polynomial, |error| <= 2e-8 rad; see nubot/core/PointArray.hpp.
+   /// Branch free, so loops calling it are vectorized by the compiler.
+   /// \return angle of (x, y) in (-PI, PI]; 0 for (0, 0). Unlike std::atan2 the sign of a zero y
+   /// is ignored, so (-1, -0) gives PI rather than -PI; see test/planar_angle.cc.
+   inline double fast_atan2(double y, double x)
+   {
+       return nubot::fast_atan2<double>(y, x);
+   }
+
+   /// \brief Angle of a target vector against a reference vector, both in the plane.
+   /// Same result as get_angle_PI() for planar vectors, without normalizing either of them.
+   /// \return angle range [-PI, PI]; positive if the target is counter-clockwise of the reference
+   inline double planar_angle(double ref_x, double ref_y, double x, double y)
+   {
+       return fast_atan2(ref_x*y - ref_y*x, ref_x*x + ref_y*y);
+   }
+
+   /// \brief Bearing of a target vector against a heading. Computes the cosine and sine of the
+   /// heading on every call; for several targets against one heading, use planar_angle() with
+   /// them precomputed, or planar_bearings().
+   /// \param[in] heading   heading angle (rad)
+   /// \param[in] dx, dy    target vector in the frame the heading is given in
+   /// \return angle range [-PI, PI]
+   inline double planar_bearing(double heading, double dx, double dy)
+   {
+       return planar_angle(std::cos(heading), std::sin(heading), dx, dy);
+   }
+
+   /// \brief Bearings and ranges of many target vectors against one heading in a single pass.
+   /// The loop has no branches and no calls, so it is compiled to SIMD instructions where available.
+   /// \param[in]  heading   heading angle (rad)
+   /// \param[in]  dx, dy    target vectors, n entries each
+   /// \param[in]  n         number of targets
+   /// \param[out] bearing   angles against the heading, [-PI, PI]
+   /// \param[out] range     lengths of the target vectors
+   inline void planar_bearings(double heading, const double * dx, const double * dy, unsigned int n,
+                               double * bearing, double * range)
+   {
+       const double c = std::cos(heading);
+       const double s = std::sin(heading);
+#if defined(_OPENMP) || defined(HAVE_OPENMP_SIMD)
+#pragma omp simd
+#endif
+       for(unsigned int i=0; i<n; i++)
+       {
+           range[i]   = std::sqrt(dx[i]*dx[i] + dy[i]*dy[i]);
+           bearing[i] = fast_atan2(c*dy[i] - s*dx[i], c*dx[i] + s*dy[i]);
+       }
+   }
+
+   /// \brief Bearings and ranges of many target vectors, each against its own heading, in a single
+   /// pass. The heading is subtracted from the direction of the target instead of rotating the
+   /// target, so there is no sine or cosine per target and the loop is compiled to SIMD instructions.
+   /// \param[in]  heading   heading angles (rad) within [-2PI, 2PI], n entries
+   /// \param[in]  dx, dy    target vectors, n entries each; entry i against heading[i]
+   /// \param[in]  n         number of targets
+   /// \param[out] bearing   angles against the headings, (-PI, PI]; 0 for a zero vector
+   /// \param[out] range     lengths of the target vectors
+   inline void planar_bearings_each(const double * heading, const double * dx, const double * dy, unsigned int n,
+                                    double * bearing, double * range)
+   {
+#if defined(_OPENMP) || defined(HAVE_OPENMP_SIMD)
+#pragma omp simd
+#endif
+       for(unsigned int i=0; i<n; i++)
+       {
+           range[i] = std::sqrt(dx[i]*dx[i] + dy[i]*dy[i]);
+           double b = fast_atan2(dy[i], dx[i]) - heading[i];
+           b = b > M_PI ? b - 2*M_PI : b;
+           b = b <= -M_PI ? b + 2*M_PI : b;
+           bearing[i] = range[i] > 0.0 ? b : 0.0;
+       }
+   }
+}
+
+#endif //! PLANAR_ANGLE_HH
@@ -0,0 +1,116 @@
+#ifndef PLANAR_STATE_HH
+#define PLANAR_STATE_HH
+
+#include "planar_angle.hh"
+
+#include <cmath>
+#include <vector>
+
+namespace gazebo{
+   /// \brief Planar states of all robots and the football, stored as structure of arrays
+   /// so that per-step passes over all agents run on contiguous memory.
+   /// Entry i belongs to model_record i of the ModelRegistry.
+   struct PlanarStates
+   {
+       std::vector<double>  x;          // position (m)
+       std::vector<double>  y;
+       std::vector<double>  yaw;        // heading (rad)
+       std::vector<double>  vx;         // linear velocity (m/s)
+       std::vector<double>  vy;
+       std::vector<double>  w;          // angular velocity around z (rad/s)
+       double               ball_z;     // height of the football (m)
+       double               ball_vz;    // vertical velocity of the football (m/s)
+
+       PlanarStates() : ball_z(0.0), ball_vz(0.0) {}
+
+       unsigned int size() const { return x.size(); }
+
+       void resize(unsigned int n)
+       {
+           x.resize(n);  y.resize(n);  yaw.resize(n);
+           vx.resize(n); vy.resize(n); w.resize(n);
+       }
+
+       void reserve(unsigned int n)
+       {
+           x.reserve(n);  y.reserve(n);  yaw.reserve(n);
+           vx.reserve(n); vy.reserve(n); w.reserve(n);
+       }
+   };
+
+   /// \brief Positions of all agents relative to one robot
+   struct EgoStates
+   {
+       std::vector<double>  dx;         // vector from the robot to the agent, world frame (m)
+       std::vector<double>  dy;
+       std::vector<double>  range;      // distance from the robot to the agent (m)
+       std::vector<double>  bearing;    // angle of the agent against the robot heading, [-PI, PI]
+
+       unsigned int size() const { return dx.size(); }
+
+       void resize(unsigned int n)
+       {
+           dx.resize(n); dy.resize(n); range.resize(n); bearing.resize(n);
+       }
+   };
+
+   /// \brief Whether a position lies inside the field area robots may be in
+   inline bool in_field(double x, double y)
+   {
+       return std::fabs(x) <= 10 && std::fabs(y) <= 7;
+   }
+
+   /// \brief Transform all agents into the ego frame of one robot in a single pass
+   /// \param[in]  states   planar states of all agents
+   /// \param[in]  origin   index of the robot the ego frame belongs to
+   /// \param[out] ego      relative vectors, ranges and bearings of all agents;
+   ///                      the entry of the robot itself is zero
+   inline void transform_to_ego(const PlanarStates & states, unsigned int origin, EgoStates & ego)
+   {
+       const unsigned int n = states.size();
+       const double ox = states.x[origin];
+       const double oy = states.y[origin];
+       ego.resize(n);
+       if(n == 0)
+           return;
+
+       const double * x = &states.x[0];
+       const double * y = &states.y[0];
+       double * dx = &ego.dx[0];
+       double * dy = &ego.dy[0];
+       for(unsigned int i=0; i<n; i++)
+       {
+           dx[i] = x[i] - ox;
+           dy[i] = y[i] - oy;
+       }
+       planar_bearings(states.yaw[origin], dx, dy, n, &ego.bearing[0], &ego.range[0]);
+   }
+
+   /// \brief Vectors from every agent to the football in a single pass
+   /// \param[in]  states   planar states of all agents
+   /// \param[in]  ball     index of the football
+   /// \param[out] ego      entry i is the football relative to agent i, with the bearing
+   ///                      against the heading of agent i
+   inline void transform_ball_to_egos(const PlanarStates & states, unsigned int ball, EgoStates & ego)
+   {
+       const unsigned int n = states.size();
+       const double bx = states.x[ball];
+       const double by = states.y[ball];
+       ego.resize(n);
+       if(n == 0)
+           return;
+
+       const double * x = &states.x[0];
+       const double * y = &states.y[0];
+       double * dx = &ego.dx[0];
+       double * dy = &ego.dy[0];
+       for(unsigned int i=0; i<n; i++)
+       {
+           dx[i] = bx - x[i];
+           dy[i] = by - y[i];
+       }
+       planar_bearings_each(&states.yaw[0], dx, dy, n, &ego.bearing[0], &ego.range[0]);
+   }
+}
+
+#endif //! PLANAR_STATE_HH
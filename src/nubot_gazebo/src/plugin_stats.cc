@@ -0,0 +1,115 @@
+#include "plugin_stats.hh"
+
+#include <algorithm>
+
+using namespace gazebo;
+
+PluginStats*    PluginStats::instance_ = NULL;
+boost::mutex    PluginStats::instance_lock_;
+
+static const char* channel_names[STAT_CHANNELS] =
+{
+    "plugin step", "world snapshot", "perception", "ball handling", "publish",
+    "ball plugin", "command lock wait", "callback queue depth"
+};
+static const char* counter_names[COUNT_COUNTERS] =
+{
+    "omni vision publishes", "team world publishes", "velcmd messages", "service calls",
+    "robot steps", "steps without new velcmd", "steps without new ball command"
+};
+
+uint64_t StatHistogram::snapshot::quantile(double q) const
+{
+    if(count == 0)
+        return 0;
+    const uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * count + 0.5));
+    uint64_t seen = 0;
+    for(int b=0; b<bucket_num; b++)
+    {
+        seen += buckets[b];
+        if(seen >= rank)
+            return std::min<uint64_t>(max, b ? (1ULL << b) - 1 : 0);
+    }
+    return max;
+}
+
+PluginStats* PluginStats::Instance(void)
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    if(!instance_)
+        instance_ = new PluginStats();
+    return instance_;
+}
+
+PluginStats::PluginStats()
+    : last_report_(clock::now()), was_enabled_(false)
+{
+    enabled_ = ParamStore::Instance()->declare("/general/instrumentation",        0.0);
+    period_  = ParamStore::Instance()->declare("/general/instrumentation_period", 5.0);
+    for(int i=0; i<COUNT_COUNTERS; i++)
+        counters_[i].store(0, std::memory_order_relaxed);
+    diagnostics_pub_ = rosnode_.advertise<diagnostic_msgs::DiagnosticArray>("/diagnostics", 10);
+
+    // one status per channel and one for the counters; only the values change between reports
+    diagnostics_.status.resize(STAT_CHANNELS + 1);
+    for(int i=0; i<=STAT_CHANNELS; i++)
+    {
+        diagnostic_msgs::DiagnosticStatus & status = diagnostics_.status[i];
+        status.level = diagnostic_msgs::DiagnosticStatus::OK;
+        status.name = std::string("nubot_gazebo: ") + (i < STAT_CHANNELS ? channel_names[i] : "counters");
+        status.hardware_id = "gzserver";
+    }
+}
+
+void PluginStats::report(void)
+{
+    if(!enabled())
+    {
+        was_enabled_ = false;
+        return;
+    }
+    clock::time_point now = clock::now();
+    boost::mutex::scoped_try_lock lock(report_lock_);
+    if(!lock.owns_lock())
+        return;
+
+    // just switched on: start with empty statistics
+    if(!was_enabled_)
+    {
+        for(int i=0; i<STAT_CHANNELS; i++)
+            histograms_[i].reset();
+        for(int i=0; i<COUNT_COUNTERS; i++)
+            counters_[i].store(0, std::memory_order_relaxed);
+        last_report_ = now;
+        was_enabled_ = true;
+        return;
+    }
+    const double period = std::chrono::duration<double>(now - last_report_).count();
+    if(period < period_->get())
+        return;
+    last_report_ = now;
+
+    StatHistogram::snapshot snapshot;
+    for(int i=0; i<STAT_CHANNELS; i++)
+    {
+        histograms_[i].take(snapshot);
+        const double scale = i == STAT_QUEUE_DEPTH ? 1.0 : 1e-3;            // ns to us
+        diagnostic_msgs::DiagnosticStatus & status = diagnostics_.status[i];
+        status.values.clear();
+        status.message = i == STAT_QUEUE_DEPTH ? "callbacks" : "us";
+        add_diagnostic_value(status, "count", snapshot.count);
+        add_diagnostic_value(status, "mean",  snapshot.count ? scale * snapshot.sum / snapshot.count : 0.0);
+        add_diagnostic_value(status, "p50",   scale * snapshot.quantile(0.50));
+        add_diagnostic_value(status, "p99",   scale * snapshot.quantile(0.99));
+        add_diagnostic_value(status, "max",   scale * snapshot.max);
+    }
+    diagnostic_msgs::DiagnosticStatus & counters = diagnostics_.status[STAT_CHANNELS];
+    counters.values.clear();
+    counters.message = "per second";
+    for(int i=0; i<COUNT_COUNTERS; i++)
+        add_diagnostic_value(counters, counter_names[i], counters_[i].exchange(0, std::memory_order_relaxed) / period);
+
+    diagnostics_.header.stamp = ros::Time::now();
+    diagnostics_.header.seq++;
+    diagnostics_pub_.publish(diagnostics_);
+}
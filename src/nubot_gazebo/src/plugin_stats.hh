@@ -0,0 +1,199 @@
+#ifndef PLUGIN_STATS_HH
+#define PLUGIN_STATS_HH
+
+#include <ros/ros.h>
+#include <diagnostic_msgs/DiagnosticArray.h>
+
+#include "param_store.hh"
+
+#include <boost/thread/mutex.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdint.h>
+#include <string>
+
+namespace gazebo{
+   /// \brief Append a key with a number, printed with three decimals, to a diagnostic status
+   inline void add_diagnostic_value(diagnostic_msgs::DiagnosticStatus & status, const std::string & key, double value)
+   {
+       char text[32];
+       snprintf(text, sizeof(text), "%.3f", value);
+       diagnostic_msgs::KeyValue key_value;
+       key_value.key = key;
+       key_value.value = text;
+       status.values.push_back(key_value);
+   }
+
+   /// \brief Overwrite entry k of a diagnostic status, which must hold k + 1 entries, with a key and
+   /// a number printed with three decimals. A status refilled with the same keys every report reuses
+   /// its strings and allocates nothing.
+   inline void set_diagnostic_value(diagnostic_msgs::DiagnosticStatus & status, unsigned int k,
+                                    const char * key, double value)
+   {
+       char text[32];
+       snprintf(text, sizeof(text), "%.3f", value);
+       status.values[k].key = key;
+       status.values[k].value = text;
+   }
+
+   /// \brief Distributions recorded by the plugins
+   enum stat_channel
+   {
+       STAT_PLUGIN_STEP,        // all plugin callbacks of a physics step (ns), from StepTimer
+       STAT_SNAPSHOT,           // world snapshot of a robot plugin (ns)
+       STAT_PERCEPTION,         // noise, coordinate flip, ego frame and stuck detection (ns)
+       STAT_BALL_HANDLING,      // dribble and kick (ns)
+       STAT_PUBLISH,            // OmniVisionInfo, odoinfo and the team's WorldModelInfo (ns)
+       STAT_BALL_PLUGIN,        // BallGazebo update (ns)
+       STAT_CMD_LOCK_WAIT,      // wait for the command lock in velcmd and service callbacks (ns)
+       STAT_QUEUE_DEPTH,        // pending callbacks of a robot plugin, sampled once per step
+       STAT_CHANNELS
+   };
+
+   /// \brief Events counted by the plugins
+   enum stat_counter
+   {
+       COUNT_OMNI_VISION,       // OmniVisionInfo and odoinfo messages published
+       COUNT_TEAM_WORLD,        // WorldModelInfo messages published
+       COUNT_VEL_CMD,           // velcmd messages received
+       COUNT_SERVICE_CALL,      // BallHandle and Shoot calls served
+       COUNT_ROBOT_STEP,        // physics steps of all robot plugins
+       COUNT_STALE_VEL_CMD,     // ... without a new velocity command
+       COUNT_STALE_BALL_CMD,    // ... without a new ball handling request
+       COUNT_COUNTERS
+   };
+
+  /// \class StatHistogram
+  /// \brief Lock-free histogram with power-of-two buckets; bucket b holds values in [2^(b-1), 2^b).
+  /// Safe to fill from any thread; relative error of the quantiles is below a factor of two.
+  class StatHistogram
+  {
+    public:
+        static const int bucket_num = 40;
+
+        StatHistogram() { reset(); }
+
+        void add(uint64_t value)
+        {
+            int bucket = value ? 64 - __builtin_clzll(value) : 0;
+            if(bucket >= bucket_num)
+                bucket = bucket_num - 1;
+            buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+            uint64_t max = max_.load(std::memory_order_relaxed);
+            while(value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+                ;
+        }
+
+        /// \brief Move the contents into a plain copy and start over
+        struct snapshot
+        {
+            uint64_t buckets[bucket_num];
+            uint64_t count, sum, max;
+
+            /// \brief Upper bound of the bucket holding quantile q
+            uint64_t quantile(double q) const;
+        };
+        void take(snapshot & out)
+        {
+            for(int i=0; i<bucket_num; i++)
+                out.buckets[i] = buckets_[i].exchange(0, std::memory_order_relaxed);
+            out.count = count_.exchange(0, std::memory_order_relaxed);
+            out.sum   = sum_.exchange(0, std::memory_order_relaxed);
+            out.max   = max_.exchange(0, std::memory_order_relaxed);
+        }
+
+        void reset(void)
+        {
+            snapshot discard;
+            take(discard);
+        }
+
+    private:
+        std::atomic<uint64_t>   buckets_[bucket_num];
+        std::atomic<uint64_t>   count_;
+        std::atomic<uint64_t>   sum_;
+        std::atomic<uint64_t>   max_;
+  };
+
+  /// \class PluginStats
+  /// \brief Instrumentation of all plugins in the gzserver process: per-stage timings of the
+  /// update callbacks, lock waits and queue depths as histograms, plus event counters. Every
+  /// period (/general/instrumentation_period, wall time) the histograms are published as
+  /// diagnostic_msgs/DiagnosticArray on /diagnostics, one status per channel with count, mean,
+  /// p50, p99 and max, and cleared. Switched on and off at run time with /general/instrumentation
+  /// through the ParamStore; when off, every probe costs one relaxed atomic load.
+  class PluginStats
+  {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        /// \brief Times a stage from construction to stop() or destruction; does nothing if
+        /// instrumentation is off when it is constructed
+        class Scope
+        {
+          public:
+            Scope(PluginStats* stats, stat_channel channel)
+                : stats_(stats && stats->enabled() ? stats : NULL), channel_(channel)
+            {
+                if(stats_)
+                    start_ = clock::now();
+            }
+            ~Scope() { stop(); }
+
+            void stop(void)
+            {
+                if(!stats_)
+                    return;
+                stats_->record(channel_, std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+                stats_ = NULL;
+            }
+          private:
+            PluginStats*        stats_;
+            stat_channel        channel_;
+            clock::time_point   start_;
+        };
+
+        /// \brief Get the process-wide instance. It is created by the first caller.
+        static PluginStats* Instance(void);
+
+        bool enabled(void) const { return enabled_->get() > 0.0; }
+
+        void record(stat_channel channel, uint64_t value)
+        {
+            if(enabled())
+                histograms_[channel].add(value);
+        }
+
+        void count(stat_counter counter, uint64_t n = 1)
+        {
+            if(enabled())
+                counters_[counter].fetch_add(n, std::memory_order_relaxed);
+        }
+
+        /// \brief Publish and clear the statistics if a period has passed. Cheap to call every
+        /// physics step; any thread.
+        void report(void);
+
+    private:
+        PluginStats();
+
+        static PluginStats*     instance_;
+        static boost::mutex     instance_lock_;
+
+        const ParamValue*       enabled_;           // /general/instrumentation
+        const ParamValue*       period_;            // /general/instrumentation_period (s)
+        StatHistogram           histograms_[STAT_CHANNELS];
+        std::atomic<uint64_t>   counters_[COUNT_COUNTERS];
+        boost::mutex            report_lock_;
+        clock::time_point       last_report_;
+        std::atomic<bool>       was_enabled_;       // enabled at the last report() call
+        ros::NodeHandle         rosnode_;
+        ros::Publisher          diagnostics_pub_;
+        diagnostic_msgs::DiagnosticArray diagnostics_;
+  };
+}
+
+#endif //! PLUGIN_STATS_HH
@@ -0,0 +1,66 @@
+#include "publish_scheduler.hh"
+
+#include <cmath>
+
+using namespace gazebo;
+
+static const double rate_window = 1.0;         // window for measuring the achieved rate (s)
+static const double max_silence = 1.0;         // longest time without publishing in change-triggered mode (s)
+
+PublishScheduler::PublishScheduler()
+{
+    configure(0.0, 0.0, 0.0);
+}
+
+void PublishScheduler::configure(double rate, double phase, double change_thres)
+{
+    period_ = rate > 0.0 ? 1.0/rate : 0.0;
+    phase_ = period_ > 0.0 ? std::fmod(phase, period_) : 0.0;
+    change_thres_ = change_thres;
+    last_slot_ = -1;
+    last_publish_time_ = -max_silence;
+    window_start_ = -1.0;
+    window_count_ = 0;
+    publish_count_ = 0;
+    achieved_rate_ = 0.0;
+}
+
+bool PublishScheduler::should_publish(double sim_time, double change)
+{
+    // simulation time goes back when the world is reset
+    if(sim_time < window_start_ || sim_time < last_publish_time_)
+    {
+        last_slot_ = -1;
+        last_publish_time_ = -max_silence;
+        window_start_ = -1.0;
+    }
+
+    // measure the achieved rate in windows of simulated time
+    if(window_start_ < 0.0)
+        window_start_ = sim_time;
+    else if(sim_time - window_start_ >= rate_window)
+    {
+        achieved_rate_ = window_count_ / (sim_time - window_start_);
+        window_start_ = sim_time;
+        window_count_ = 0;
+    }
+
+    // one publish per slot [phase + k*period, phase + (k+1)*period)
+    long slot = 0;
+    if(period_ > 0.0)
+    {
+        slot = (long)std::floor((sim_time - phase_) / period_);
+        if(slot == last_slot_)
+            return false;
+    }
+
+    if(change_thres_ > 0.0 && change < change_thres_ &&
+       sim_time - last_publish_time_ < max_silence)
+        return false;
+
+    last_slot_ = slot;
+    last_publish_time_ = sim_time;
+    window_count_++;
+    publish_count_++;
+    return true;
+}
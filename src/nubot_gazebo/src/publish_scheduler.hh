@@ -0,0 +1,48 @@
+#ifndef PUBLISH_SCHEDULER_HH
+#define PUBLISH_SCHEDULER_HH
+
+namespace gazebo{
+  /// \class PublishScheduler
+  /// \brief Decides on which simulation steps a message is published. Keyed on simulated time,
+  /// so the publish rate does not depend on the real time factor.
+  class PublishScheduler
+  {
+    public:
+        PublishScheduler();
+
+        /// \brief Set up the scheduler
+        /// \param[in] rate          publish rate in Hz of simulated time; <= 0 publishes every step
+        /// \param[in] phase         offset of the publish slots in seconds, so that robots don't all
+        ///                          publish in the same step
+        /// \param[in] change_thres  if > 0, only publish when the state changed by at least this much
+        ///                          since the last publish; at least once per second anyway
+        void configure(double rate, double phase, double change_thres);
+
+        /// \brief Whether to publish in this step. Marks the message as published if so.
+        /// \param[in] sim_time  simulation time of this step (s)
+        /// \param[in] change    how much the state changed since the last publish; only used
+        ///                      when a change threshold is configured
+        bool should_publish(double sim_time, double change = 0.0);
+
+        /// \brief publish rate over the last completed one-second window of simulated time (Hz)
+        double achieved_rate(void) const { return achieved_rate_; }
+
+        /// \brief number of messages published since configure()
+        unsigned long publish_count(void) const { return publish_count_; }
+
+        bool change_triggered(void) const { return change_thres_ > 0.0; }
+
+    private:
+        double          period_;            // 1/rate; 0 means every step
+        double          phase_;
+        double          change_thres_;
+        long            last_slot_;         // slot index of the last publish
+        double          last_publish_time_;
+        double          window_start_;      // start of the current rate window
+        unsigned long   window_count_;      // publishes in the current rate window
+        unsigned long   publish_count_;
+        double          achieved_rate_;
+  };
+}
+
+#endif //! PUBLISH_SCHEDULER_HH
@@ -0,0 +1,227 @@
+#include "robot_behaviour.hh"
+#include "nubot/core/core.hpp"
+
+#include <cmath>
+
+using namespace gazebo;
+
+static const double goal_x = 9.0;
+static const double goal_height = 1.0;
+static const double g = 9.8;
+static const double dribble_offset = 0.43;             // distance from robot origin to the dribbled ball (m)
+static const double dribble_height = 0.12;             // height of the dribbled ball (m)
+static const double run_gain = 2.3;                    // RUN mode: ball velocity per unit of kick strength. FIXME. CAN TUNE
+static const double stuck_scale = 0.5;                 // failed if moving slower than this share of the command. FIXME. Can tune
+
+RobotBehaviour::RobotBehaviour()
+{
+    noise_scale_ = noise_rate_ = 0.0;
+    flip_cord_ = false;
+    robot_ = ball_ = agent_state();
+    for(int i=0; i<GOAL_SIDES; i++)
+        goal_x_[i] = goal_y_[i] = goal_range_[i] = goal_bearing_[i] = 0.0;
+    goals_known_ = false;
+    reset();
+}
+
+void RobotBehaviour::configure(bool flip_cord, uint64_t noise_seed, uint64_t noise_stream,
+                               double stuck_window, unsigned int stuck_capacity, double stuck_ratio)
+{
+    flip_cord_ = flip_cord;
+    noise_.seed(noise_seed, noise_stream);
+    stuck_detector_.configure(stuck_window, stuck_capacity, stuck_ratio);
+    reset();
+}
+
+void RobotBehaviour::set_params(double noise_scale, double noise_rate)
+{
+    noise_scale_            = noise_scale;
+    noise_rate_             = noise_rate;
+}
+
+void RobotBehaviour::reset(void)
+{
+    kick_x_ = 1.0;                 // the kicking mechanism is in x-axis direction of the robot frame
+    kick_y_ = 0.0;
+    ball_range_ = 1.0;
+    ball_bearing_ = 0.0;
+    desired_vx_ = desired_vy_ = desired_w_ = 0.0;
+    commanded_ = false;
+    stuck_detector_.reset();
+}
+
+void RobotBehaviour::set_goals(double left_x, double left_y, double right_x, double right_y)
+{
+    goal_x_[LEFT_GOAL]  = left_x;
+    goal_y_[LEFT_GOAL]  = left_y;
+    goal_x_[RIGHT_GOAL] = right_x;
+    goal_y_[RIGHT_GOAL] = right_y;
+    if(flip_cord_)      // the world's right goal lies at -x of a rival robot's frame
+    {
+        goal_x_[LEFT_GOAL]  = -right_x;
+        goal_y_[LEFT_GOAL]  = -right_y;
+        goal_x_[RIGHT_GOAL] = -left_x;
+        goal_y_[RIGHT_GOAL] = -left_y;
+    }
+    goals_known_ = true;
+}
+
+void RobotBehaviour::perceive(const PlanarStates & world, uint64_t step)
+{
+    perceived_ = world;                             // no allocation once perceived_ has the same size
+    const unsigned int n = perceived_.size();
+
+    // add gaussian noise to x, y, vx and vy of every agent, all samples of the step at once
+    noise_buf_.resize(4*n);
+    if(n == 0)
+        return;
+    noise_.generate(step, 4*n, noise_scale_, noise_rate_, &noise_buf_[0]);
+    const double * noise = &noise_buf_[0];
+    for(unsigned int i=0; i<n; i++)
+    {
+        perceived_.x[i]  += noise[i];
+        perceived_.y[i]  += noise[n + i];
+        perceived_.vx[i] += noise[2*n + i];
+        perceived_.vy[i] += noise[3*n + i];
+    }
+
+    if(flip_cord_)      // rival robot model
+    {
+        // We only have to change the sign of x and y positions, and x and y velocities;
+        // Since the coordinate frame of the rival model has been flipped, we don't have
+        // to change the orientation here.
+        for(unsigned int i=0; i<n; i++)
+        {
+            perceived_.x[i]  = -perceived_.x[i];
+            perceived_.y[i]  = -perceived_.y[i];
+            perceived_.vx[i] = -perceived_.vx[i];
+            perceived_.vy[i] = -perceived_.vy[i];
+        }
+    }
+}
+
+void RobotBehaviour::get_agent_state(int i, agent_state & state) const
+{
+    state.x   = perceived_.x[i];
+    state.y   = perceived_.y[i];
+    state.z   = 0.0;
+    state.yaw = perceived_.yaw[i];
+    state.vx  = perceived_.vx[i];
+    state.vy  = perceived_.vy[i];
+    state.vz  = 0.0;
+    state.w   = perceived_.w[i];
+}
+
+void RobotBehaviour::update(const PlanarStates & world, uint64_t step, double sim_time,
+                            int robot, int ball, const PhysicsBackend & physics)
+{
+    // all agents as seen by me and relative to me, each in one pass over contiguous arrays
+    perceive(world, step);
+    transform_to_ego(perceived_, robot, ego_);
+
+    // Get football and nubot's pose and twist
+    get_agent_state(ball, ball_);
+    ball_.z  = perceived_.ball_z;
+    ball_.vz = perceived_.ball_vz;
+    get_agent_state(robot, robot_);
+    robot_.z = physics.robot_height();
+
+    // vector from nubot to football
+    ball_range_   = ego_.range[ball];
+    ball_bearing_ = ego_.bearing[ball];
+
+    // vector from nubot origin to kicking mechanism in world frame
+    kick_x_ = std::cos(robot_.yaw);
+    kick_y_ = std::sin(robot_.yaw);
+
+    // goals in the same pass, against the heading above; they are static, so only the robot's own pose carries noise
+    if(goals_known_)
+        for(int i=0; i<GOAL_SIDES; i++)
+        {
+            const double dx = goal_x_[i] - robot_.x;
+            const double dy = goal_y_[i] - robot_.y;
+            goal_range_[i]   = std::sqrt(dx*dx + dy*dy);
+            goal_bearing_[i] = planar_angle(kick_x_, kick_y_, dx, dy);
+        }
+
+    update_stuck(sim_time);
+}
+
+void RobotBehaviour::update_stuck(double sim_time)
+{
+    bool failed = false;
+    if(commanded_)                  // only after nubot tends to move can I judge if it is stuck
+    {
+        double desired_trans_length = std::sqrt(desired_vx_*desired_vx_ + desired_vy_*desired_vy_);
+        double desired_rot_length   = std::fabs(desired_w_);
+        double actual_trans_length  = std::sqrt(robot_.vx*robot_.vx + robot_.vy*robot_.vy);
+        double actual_rot_length    = std::fabs(robot_.w);
+
+        failed = actual_trans_length < desired_trans_length * stuck_scale ||     // cannot translate
+                 actual_rot_length   < desired_rot_length * stuck_scale;         // cannot rotate
+    }
+    stuck_detector_.update(sim_time, commanded_, failed);
+    commanded_ = false;
+}
+
+void RobotBehaviour::move(double Vx, double Vy, double w, PhysicsBackend & physics)
+{
+    // Vx along the kicking mechanism, Vy perpendicular to it (z cross kick vector)
+    desired_vx_ = Vx * kick_x_ - Vy * kick_y_;
+    desired_vy_ = Vx * kick_y_ + Vy * kick_x_;
+    desired_w_  = w;
+    physics.set_robot_velocity(desired_vx_, desired_vy_, desired_w_);
+    commanded_ = true;                                  // only afetr nubot tends to move can I judge if it is stuck
+}
+
+void RobotBehaviour::dribble_ball(PhysicsBackend & physics)
+{
+    double target_x = robot_.x + kick_x_ * dribble_offset;
+    double target_y = robot_.y + kick_y_ * dribble_offset;
+    if(flip_cord_)
+    {
+        target_x = -target_x;
+        target_y = -target_y;
+    }
+    physics.set_ball_pose(target_x, target_y, dribble_height, robot_.yaw);
+    ball_.vx = robot_.vx;
+    ball_.vy = robot_.vy;
+    ball_.vz = 0.0;
+}
+
+kick_result RobotBehaviour::kick_ball(int mode, double vel, PhysicsBackend & physics)
+{
+    const double sign = flip_cord_ ? -1.0 : 1.0;
+
+    if(mode == RUN)
+    {
+        double vel2 = vel * run_gain;
+        physics.set_ball_velocity(sign * kick_x_ * vel2, sign * kick_y_ * vel2, 0.0);
+        return KICK_DONE;
+    }
+    else if(mode == FLY)
+    {
+        // math formular: y = a*x^2 + b*x + c;
+        //  a = -g/(2*vx*vx), c = 0, b = kick_goal_height/D + g*D/(2.0*vx*vx)
+        //  mid_point coordinates:[-b/(2*a), (4a*c-b^2)/(4a) ]
+
+        static const double kick_goal_height = goal_height - 0.20;      // FIXME: can be tuned
+        nubot::DPoint point1(robot_.x, robot_.y);
+        nubot::DPoint point2(robot_.x + kick_x_, robot_.y + kick_y_);
+        nubot::DPoint point3(ball_.x, ball_.y);
+        nubot::Line_ line1(point1, point2);
+        nubot::Line_ line2(1.0, 0.0, kick_x_>0 ? -goal_x : goal_x);        // nubot::Line_(A,B,C);
+
+        nubot::DPoint crosspoint = line1.crosspoint(line2);
+        double D = crosspoint.distance(point3);
+        double vx_thres = D*std::sqrt(g/2/kick_goal_height);
+        double vx = vx_thres/2.0;                                          // initial x velocity.CAN BE TUNED
+        double b = kick_goal_height/D + g*D/(2.0*vx*vx);
+
+        if(std::fabs(crosspoint.y_) >= 10)
+            return KICK_OUT_OF_RANGE;
+        physics.set_ball_velocity(sign * vx * kick_x_, sign * vx * kick_y_, b * vx);
+        return KICK_DONE;
+    }
+    return KICK_BAD_MODE;
+}
@@ -0,0 +1,169 @@
+#ifndef ROBOT_BEHAVIOUR_HH
+#define ROBOT_BEHAVIOUR_HH
+
+#include "physics_backend.hh"
+#include "planar_state.hh"
+#include "noise_generator.hh"
+#include "stuck_detector.hh"
+
+#include <stdint.h>
+#include <vector>
+
+namespace gazebo{
+   /// \brief Kick ball mode, as in the ShootPos field of the Shoot service
+   enum kick_mode
+   {
+       RUN = 1,                     // along the ground
+       FLY = -1                     // lob towards the goal
+   };
+
+   /// \brief Result of RobotBehaviour::kick_ball()
+   enum kick_result
+   {
+       KICK_DONE,
+       KICK_OUT_OF_RANGE,           // FLY: the lob would not end near the goal
+       KICK_BAD_MODE
+   };
+
+   /// \brief Goals of the field as seen by a robot, in its own (possibly flipped) frame
+   enum goal_side
+   {
+       LEFT_GOAL,                   // at -x of the robot's own frame
+       RIGHT_GOAL,                  // at +x of the robot's own frame; the goal the robot attacks
+       GOAL_SIDES
+   };
+
+   /// \brief State of one agent in the robot's own (possibly flipped) coordinate frame
+   struct agent_state
+   {
+       double x, y, z;              // position (m)
+       double yaw;                  // heading (rad)
+       double vx, vy, vz;           // linear velocity (m/s)
+       double w;                    // angular velocity around z (rad/s)
+   };
+
+  /// \class RobotBehaviour
+  /// \brief Perception, locomotion, dribbling, kicking and stuck detection of
+  /// one robot, without any dependency on Gazebo or ROS. The engine is only reached through a
+  /// PhysicsBackend, so the same code runs in the Gazebo plugin and in cheaper simulators.
+  /// All states are in the robot's own frame, i.e. flipped for rival robots; the backend is
+  /// always driven in the world frame.
+  class RobotBehaviour
+  {
+    public:
+        RobotBehaviour();
+
+        /// \brief Set up the robot; forgets all state
+        /// \param[in] flip_cord        rival robot: its coordinate frame is rotated by 180 degrees
+        /// \param[in] noise_seed       base seed of the perception noise of the run
+        /// \param[in] noise_stream     noise stream of this robot, unique within the run
+        /// \param[in] stuck_window     see StuckDetector::configure()
+        /// \param[in] stuck_capacity
+        /// \param[in] stuck_ratio
+        void configure(bool flip_cord, uint64_t noise_seed, uint64_t noise_stream,
+                       double stuck_window, unsigned int stuck_capacity, double stuck_ratio);
+
+        /// \brief Set the tunable parameters; may change every step. Who holds the ball is decided
+        /// for the whole world by BallPossession.
+        /// \param[in] noise_scale              scale of gaussian noise
+        /// \param[in] noise_rate               how frequent the noise generates
+        void set_params(double noise_scale, double noise_rate);
+
+        /// \brief Forget the commands and the stuck history, e.g. when the world is reset
+        void reset(void);
+
+        /// \brief Set the positions of the goals; call after configure(). Until they are set,
+        /// goal_range() and goal_bearing() stay 0.
+        /// \param[in] left_x, left_y     center of the goal at -x of the world frame (m)
+        /// \param[in] right_x, right_y   center of the goal at +x of the world frame (m)
+        void set_goals(double left_x, double left_y, double right_x, double right_y);
+
+        /// \brief Take the world state of a step. Runs perception, the ego transform and stuck
+        /// detection, so call it exactly once per step and before any command of the step.
+        /// \param[in] world    planar states in world frame
+        /// \param[in] step     world iteration; selects the noise samples
+        /// \param[in] sim_time simulation time of the step (s)
+        /// \param[in] robot    index of this robot in world
+        /// \param[in] ball     index of the football in world
+        /// \param[in] physics  engine of the robot
+        void update(const PlanarStates & world, uint64_t step, double sim_time,
+                    int robot, int ball, const PhysicsBackend & physics);
+
+        /// \brief Nubot moving function: rotation + translation
+        /// \param[in] Vx,Vy    linear velocity in the robot frame (m/s), already in the robot's coordinate frame
+        /// \param[in] w        angular velocity (rad/s)
+        /// \param[in] physics  engine of the robot
+        void move(double Vx, double Vy, double w, PhysicsBackend & physics);
+
+        /// \brief Nubot dribbling ball function. The football follows nubot movement.
+        void dribble_ball(PhysicsBackend & physics);
+
+        /// \brief Nubot kicking ball
+        /// \param[in] mode     kick ball mode FLY or RUN
+        /// \param[in] vel      initial velocity of the ball kicked; used in RUN mode; not used in FLY mode
+        /// \param[in] physics  engine of the robot
+        kick_result kick_ball(int mode, double vel, PhysicsBackend & physics);
+
+        /// \brief Result of stuck detection in the last update()
+        bool stuck(void) const { return stuck_detector_.stuck(); }
+
+        bool flip_cord(void) const { return flip_cord_; }
+
+        /// \brief All agents as perceived by this robot, i.e. with noise and flipped
+        const PlanarStates & perceived(void) const { return perceived_; }
+
+        /// \brief All agents relative to this robot
+        const EgoStates & ego(void) const { return ego_; }
+
+        const agent_state & robot(void) const { return robot_; }
+        const agent_state & ball(void) const { return ball_; }
+
+        /// \brief Distance from the robot to the football (m)
+        double ball_range(void) const { return ball_range_; }
+
+        /// \brief Angle of the football against the robot heading, [-PI, PI]
+        double ball_bearing(void) const { return ball_bearing_; }
+
+        bool goals_known(void) const { return goals_known_; }
+
+        /// \brief Distance from the robot to the center of a goal (m)
+        double goal_range(goal_side side) const { return goal_range_[side]; }
+
+        /// \brief Angle of the center of a goal against the robot heading, [-PI, PI]
+        double goal_bearing(goal_side side) const { return goal_bearing_[side]; }
+
+    private:
+        /// \brief Add noise to the world state and flip it for rival robots
+        void perceive(const PlanarStates & world, uint64_t step);
+
+        /// \brief Feed the stuck detector with this step
+        void update_stuck(double sim_time);
+
+        /// \brief Copy entry i of perceived_ into an agent_state
+        void get_agent_state(int i, agent_state & state) const;
+
+        NoiseGenerator              noise_;                 // perception noise stream of this robot
+        std::vector<double>         noise_buf_;             // noise samples of one step; 4 per agent
+        StuckDetector               stuck_detector_;        // commanded vs. actual motion over a window of sim time
+        PlanarStates                perceived_;
+        EgoStates                   ego_;
+        agent_state                 robot_;
+        agent_state                 ball_;
+        double                      kick_x_, kick_y_;       // unit vector from robot origin to kicking mechanism
+        double                      ball_range_;
+        double                      ball_bearing_;
+        double                      goal_x_[GOAL_SIDES];    // goal centers in the robot's own frame
+        double                      goal_y_[GOAL_SIDES];
+        double                      goal_range_[GOAL_SIDES];
+        double                      goal_bearing_[GOAL_SIDES];
+        bool                        goals_known_;
+        double                      desired_vx_, desired_vy_, desired_w_;   // last commanded velocity, world frame
+        bool                        commanded_;             // moved since the last update; only then stuck is judged
+
+        double                      noise_scale_;
+        double                      noise_rate_;
+        bool                        flip_cord_;
+  };
+}
+
+#endif //! ROBOT_BEHAVIOUR_HH
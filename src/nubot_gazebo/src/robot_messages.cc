@@ -0,0 +1,133 @@
+#include "robot_messages.hh"
+
+#define M2CM_CONVERSION 100
+
+enum {NOTSEEBALL = 0, SEEBALLBYOWN = 1,SEEBALLBYOTHERS = 2};
+
+using namespace gazebo;
+
+void gazebo::fill_robot_messages(const RobotBehaviour & behaviour, const std::vector<int> & obstacles,
+                                 const robot_message_state & state, const ros::Time & stamp,
+                                 nubot_common::OminiVisionInfo & omni_info, nubot_common::OdoInfo & odo_info)
+{
+    const PlanarStates & perceived = behaviour.perceived();
+    const EgoStates & ego = behaviour.ego();
+    const agent_state & ball = behaviour.ball();
+    const agent_state & robot = behaviour.robot();
+
+    ////////////// OminiVision message /////////////////////////
+    nubot_common::BallInfo & ball_info = omni_info.ballinfo;
+    ball_info.header.stamp = stamp;
+    ball_info.header.seq++;
+    ball_info.ballinfostate = SEEBALLBYOWN;
+    ball_info.pos.x =  ball.x * M2CM_CONVERSION;
+    ball_info.pos.y =  ball.y * M2CM_CONVERSION;
+    ball_info.real_pos.angle  = behaviour.ball_bearing();
+    ball_info.real_pos.radius = behaviour.ball_range() * M2CM_CONVERSION;
+    ball_info.velocity.x = ball.vx * M2CM_CONVERSION;
+    ball_info.velocity.y = ball.vy * M2CM_CONVERSION;
+    ball_info.pos_known = true;
+    ball_info.velocity_known = true;
+
+    // Obstacles info (including teamates and opponent robots)
+    nubot_common::ObstaclesInfo & obstacles_info = omni_info.obstacleinfo;
+    obstacles_info.header.stamp = stamp;
+    obstacles_info.header.seq++;
+    for(unsigned int k = 0; k < obstacles.size(); k++)
+    {
+        const int i = obstacles[k];
+        nubot_common::Point2d & point = obstacles_info.pos[k];            // message type in ObstaclesInfo.msg
+        nubot_common::PPoint  & polar_point = obstacles_info.polar_pos[k];
+        point.x = perceived.x[i] * M2CM_CONVERSION;
+        point.y = perceived.y[i] * M2CM_CONVERSION;
+        polar_point.angle  = ego.bearing[i];
+        polar_point.radius = ego.range[i];
+    }
+
+    // Only this robot's own info; the whole team is in the team's WorldModelInfo
+    nubot_common::RobotInfo & self_info = omni_info.robotinfo[0];
+    self_info.header.seq++;
+    self_info.header.stamp = stamp;
+    self_info.AgentID       = state.agent_id;
+    self_info.pos.x         = robot.x * M2CM_CONVERSION;
+    self_info.pos.y         = robot.y * M2CM_CONVERSION;
+    self_info.heading.theta = robot.yaw;
+    self_info.vrot          = robot.w;
+    self_info.vtrans.x      = robot.vx * M2CM_CONVERSION;
+    self_info.vtrans.y      = robot.vy * M2CM_CONVERSION;
+    self_info.isvalid       = state.valid;
+    self_info.isstuck       = behaviour.stuck();
+    self_info.isdribble     = state.hold_ball;
+
+    // goals in polar coordinates of the robot's own frame, like the football
+    nubot_common::GoalInfo & goal_info = omni_info.goalinfo;
+    goal_info.header.stamp = stamp;
+    goal_info.header.seq++;
+    goal_info.pos_known          = behaviour.goals_known();
+    goal_info.left_goal.angle    = behaviour.goal_bearing(LEFT_GOAL);
+    goal_info.left_goal.radius   = behaviour.goal_range(LEFT_GOAL) * M2CM_CONVERSION;
+    goal_info.right_goal.angle   = behaviour.goal_bearing(RIGHT_GOAL);
+    goal_info.right_goal.radius  = behaviour.goal_range(RIGHT_GOAL) * M2CM_CONVERSION;
+
+    omni_info.header.stamp = stamp;
+    omni_info.header.seq++;
+
+    ////////////// Odometry message /////////////////////////
+    odo_info.header.stamp = stamp;
+    odo_info.header.seq++;
+    odo_info.Vx = robot.vx * M2CM_CONVERSION;
+    odo_info.Vy = robot.vy * M2CM_CONVERSION;
+    odo_info.w  = robot.w;
+    odo_info.RobotStuck = behaviour.stuck();
+    odo_info.PowerState = true;
+}
+
+void gazebo::fill_team_world_model(const PlanarStates & states, const team_world_layout & layout,
+                                   const std::vector<char> & stuck, int ball, int holder, const ros::Time & stamp,
+                                   nubot_common::WorldModelInfo & world_model)
+{
+    const double sign = layout.magenta ? -1.0 : 1.0;                // same flipping as the robot plugins
+
+    for(unsigned int k = 0; k < layout.teammates.size(); k++)
+    {
+        const int i = layout.teammates[k];
+        const double x = sign * states.x[i];
+        const double y = sign * states.y[i];
+        nubot_common::RobotInfo & robot_info = world_model.robotinfo[k];
+        robot_info.header.seq++;
+        robot_info.header.stamp = stamp;
+        robot_info.AgentID       = layout.agent_ids[k];
+        robot_info.pos.x         = x * M2CM_CONVERSION;
+        robot_info.pos.y         = y * M2CM_CONVERSION;
+        robot_info.heading.theta = states.yaw[i];
+        robot_info.vrot          = states.w[i];
+        robot_info.vtrans.x      = sign * states.vx[i] * M2CM_CONVERSION;
+        robot_info.vtrans.y      = sign * states.vy[i] * M2CM_CONVERSION;
+        robot_info.isvalid       = in_field(x, y);
+        robot_info.isstuck       = stuck[i];
+        robot_info.isdribble     = i == holder;
+    }
+    for(unsigned int k = 0; k < layout.opponents.size(); k++)
+    {
+        const int i = layout.opponents[k];
+        nubot_common::Point2d & point = world_model.oppinfo.pos[k];
+        point.x = sign * states.x[i] * M2CM_CONVERSION;
+        point.y = sign * states.y[i] * M2CM_CONVERSION;
+    }
+
+    nubot_common::BallInfo & ball_info = world_model.ballinfo[0];
+    ball_info.header.seq++;
+    ball_info.header.stamp = stamp;
+    ball_info.ballinfostate = SEEBALLBYOWN;
+    ball_info.pos.x      = sign * states.x[ball] * M2CM_CONVERSION;
+    ball_info.pos.y      = sign * states.y[ball] * M2CM_CONVERSION;
+    ball_info.velocity.x = sign * states.vx[ball] * M2CM_CONVERSION;
+    ball_info.velocity.y = sign * states.vy[ball] * M2CM_CONVERSION;
+    ball_info.pos_known = true;
+    ball_info.velocity_known = true;
+
+    world_model.oppinfo.header.seq++;
+    world_model.oppinfo.header.stamp = stamp;
+    world_model.header.seq++;
+    world_model.header.stamp = stamp;
+}
@@ -0,0 +1,57 @@
+#ifndef ROBOT_MESSAGES_HH
+#define ROBOT_MESSAGES_HH
+
+#include <ros/time.h>
+#include "nubot_common/OminiVisionInfo.h"
+#include "nubot_common/OdoInfo.h"
+#include "nubot_common/WorldModelInfo.h"
+
+#include <vector>
+
+#include "robot_behaviour.hh"
+
+namespace gazebo{
+   /// \brief What the messages of a robot carry besides its RobotBehaviour
+   struct robot_message_state
+   {
+       int          agent_id;
+       bool         valid;                  // the robot is inside the field
+       bool         hold_ball;              // the robot holds the football
+   };
+
+  /// \brief Fill the OmniVisionInfo and OdoInfo of a robot from its RobotBehaviour after update(),
+  /// as NubotGazebo and NubotSim2D publish them. Lengths go out in cm. The messages are filled in
+  /// place and no memory is allocated, as long as the obstacle arrays of omni_info hold
+  /// obstacles.size() entries and robotinfo holds one.
+  /// \param[in] behaviour      the robot
+  /// \param[in] obstacles      indices of the other robots in the world state, in message order
+  /// \param[in] state          see robot_message_state
+  /// \param[in] stamp          time of all headers
+  void fill_robot_messages(const RobotBehaviour & behaviour, const std::vector<int> & obstacles,
+                           const robot_message_state & state, const ros::Time & stamp,
+                           nubot_common::OminiVisionInfo & omni_info, nubot_common::OdoInfo & odo_info);
+
+   /// \brief Robots of a team's WorldModelInfo, worked out when models are added or removed
+   struct team_world_layout
+   {
+       bool                 magenta;                // the team's frame is flipped
+       std::vector<int>     teammates;              // indices in the world state, in robotinfo order
+       std::vector<int>     agent_ids;              // of the teammates
+       std::vector<int>     opponents;              // indices in the world state, in oppinfo order
+   };
+
+  /// \brief Fill the WorldModelInfo of a team from the noise-free world state, as TeamWorldPublisher
+  /// publishes it, in the team's own frame. Lengths go out in cm. The message is filled in place and
+  /// no memory is allocated, as long as robotinfo holds layout.teammates.size() entries, oppinfo.pos
+  /// layout.opponents.size() and ballinfo one.
+  /// \param[in] states         robots and the football
+  /// \param[in] layout         see team_world_layout
+  /// \param[in] stuck          stuck flags of the robots, by index in states
+  /// \param[in] ball, holder   indices of the football and of the robot holding it; -1 if none holds it
+  /// \param[in] stamp          time of all headers
+  void fill_team_world_model(const PlanarStates & states, const team_world_layout & layout,
+                             const std::vector<char> & stuck, int ball, int holder, const ros::Time & stamp,
+                             nubot_common::WorldModelInfo & world_model);
+}
+
+#endif //! ROBOT_MESSAGES_HH
@@ -0,0 +1,55 @@
+#include "step_timer.hh"
+
+using namespace gazebo;
+
+StepTimer*      StepTimer::instance_ = NULL;
+boost::mutex    StepTimer::instance_lock_;
+
+static const double report_period = 1.0;      // wall time between reports (s)
+
+StepTimer* StepTimer::Instance(void)
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    if(!instance_)
+        instance_ = new StepTimer();
+    return instance_;
+}
+
+StepTimer::StepTimer()
+    : stats_(PluginStats::Instance()), iteration_(0), step_plugin_time_(0.0), window_start_(clock::now()),
+      window_plugin_time_(0.0), window_max_time_(0.0), window_steps_(0)
+{
+    step_time_pub_ = rosnode_.advertise<std_msgs::Float64MultiArray>("/nubot_gazebo/plugin_step_time", 10);
+    step_time_.data.resize(4);
+}
+
+void StepTimer::add(uint64_t iteration, clock::time_point start, clock::time_point end)
+{
+    if(iteration != iteration_)
+    {
+        // close the previous step
+        window_plugin_time_ += step_plugin_time_;
+        window_max_time_ = std::max(window_max_time_, step_plugin_time_);
+        window_steps_++;
+        stats_->record(STAT_PLUGIN_STEP, (uint64_t)(step_plugin_time_ * 1e9));
+        stats_->report();
+        iteration_ = iteration;
+        step_plugin_time_ = 0.0;
+
+        double window = std::chrono::duration<double>(start - window_start_).count();
+        if(window >= report_period)
+        {
+            step_time_.data[0] = window_plugin_time_ / window_steps_ * 1000.0;
+            step_time_.data[1] = window_max_time_ * 1000.0;
+            step_time_.data[2] = window_plugin_time_ / window;
+            step_time_.data[3] = window_steps_;
+            step_time_pub_.publish(step_time_);
+            ROS_DEBUG("StepTimer: plugins take %.3f ms per step (max %.3f ms), %.1f%% of the wall time",
+                      step_time_.data[0], step_time_.data[1], step_time_.data[2] * 100.0);
+            window_start_ = start;
+            window_plugin_time_ = window_max_time_ = 0.0;
+            window_steps_ = 0;
+        }
+    }
+    step_plugin_time_ += std::chrono::duration<double>(end - start).count();
+}
@@ -0,0 +1,66 @@
+#ifndef STEP_TIMER_HH
+#define STEP_TIMER_HH
+
+#include <gazebo/physics/physics.hh>
+#include <ros/ros.h>
+#include <std_msgs/Float64MultiArray.h>
+
+#include "plugin_stats.hh"
+
+#include <boost/thread/mutex.hpp>
+#include <chrono>
+#include <stdint.h>
+
+namespace gazebo{
+  /// \class StepTimer
+  /// \brief Measures how much wall time each physics step spends in the update callbacks of our
+  /// plugins, i.e. outside Gazebo itself. Once per second of wall time it publishes
+  /// /nubot_gazebo/plugin_step_time (std_msgs/Float64MultiArray):
+  ///     [mean plugin time per step (ms), max plugin time per step (ms),
+  ///      share of the step period spent in plugins, steps in the window]
+  /// Every step also goes into the PluginStats histograms, which are reported from here.
+  /// Physics thread only.
+  class StepTimer
+  {
+    public:
+        typedef std::chrono::steady_clock clock;
+
+        /// \brief Times one update callback from construction to destruction
+        class Scope
+        {
+          public:
+            Scope(StepTimer* timer, uint64_t iteration)
+                : timer_(timer), iteration_(iteration), start_(clock::now()) {}
+            ~Scope() { if(timer_) timer_->add(iteration_, start_, clock::now()); }
+          private:
+            StepTimer*          timer_;
+            uint64_t            iteration_;
+            clock::time_point   start_;
+        };
+
+        /// \brief Get the process-wide timer. It is created by the first caller.
+        static StepTimer* Instance(void);
+
+        /// \brief Account the time of one callback to a world iteration
+        void add(uint64_t iteration, clock::time_point start, clock::time_point end);
+
+    private:
+        StepTimer();
+
+        static StepTimer*       instance_;
+        static boost::mutex     instance_lock_;
+
+        PluginStats*            stats_;
+        ros::NodeHandle         rosnode_;
+        ros::Publisher          step_time_pub_;
+        std_msgs::Float64MultiArray step_time_;
+        uint64_t                iteration_;         // iteration being accounted
+        double                  step_plugin_time_;  // plugin time in that iteration (s)
+        clock::time_point       window_start_;
+        double                  window_plugin_time_;
+        double                  window_max_time_;
+        unsigned long           window_steps_;
+  };
+}
+
+#endif //! STEP_TIMER_HH
@@ -0,0 +1,91 @@
+#ifndef STUCK_DETECTOR_HH
+#define STUCK_DETECTOR_HH
+
+#include <vector>
+
+namespace gazebo{
+  /// \class StuckDetector
+  /// \brief Decides whether a robot is stuck from the steps in which it was commanded to move.
+  /// Keeps those steps of the last window of simulated time in a fixed-size ring buffer; the robot
+  /// is stuck if the samples cover the whole window and at least a given share of them failed,
+  /// i.e. the robot moved much slower than commanded. Each update is O(1).
+  class StuckDetector
+  {
+    public:
+        StuckDetector() { configure(0.6, 64, 1.0); }
+
+        /// \brief Set up the detector and forget all samples
+        /// \param[in] window       length of the window in seconds of simulated time
+        /// \param[in] capacity     maximum number of samples kept; should cover the window at the physics rate
+        /// \param[in] ratio        share of failed samples in the window above which the robot is stuck, (0,1]
+        void configure(double window, unsigned int capacity, double ratio)
+        {
+            window_ = window;
+            ratio_ = ratio;
+            time_.assign(capacity > 0 ? capacity : 1, 0.0);
+            failed_.assign(time_.size(), false);
+            reset();
+        }
+
+        /// \brief Forget all samples, e.g. when the world is reset
+        void reset(void)
+        {
+            head_ = count_ = failed_count_ = 0;
+            stuck_ = false;
+        }
+
+        /// \brief Update with one physics step. Called once per step.
+        /// \param[in] sim_time     simulation time of the step (s)
+        /// \param[in] commanded    the robot was commanded to move in this step; only such steps are sampled
+        /// \param[in] failed       the robot moved much slower than commanded
+        /// \return whether the robot is stuck now
+        bool update(double sim_time, bool commanded, bool failed)
+        {
+            const unsigned int capacity = time_.size();
+            if(count_ > 0 && sim_time < time_[(head_ + capacity - 1) % capacity])
+                reset();                                    // simulation time went back
+
+            if(commanded)
+            {
+                if(count_ == capacity)                      // full: overwrite the oldest sample
+                    pop();
+                time_[head_] = sim_time;
+                failed_[head_] = failed;
+                head_ = (head_ + 1) % capacity;
+                count_++;
+                failed_count_ += failed;
+            }
+
+            // drop samples older than the window; each sample is dropped once, so O(1) amortized
+            while(count_ > 0 && sim_time - time_[tail()] > window_)
+                pop();
+
+            // the window is covered if its oldest sample is about a window old
+            const bool covered = count_ > 0 && sim_time - time_[tail()] >= window_ * 0.9;
+            stuck_ = covered && failed_count_ >= ratio_ * count_;
+            return stuck_;
+        }
+
+        bool stuck(void) const { return stuck_; }
+
+    private:
+        unsigned int tail(void) const { return (head_ + time_.size() - count_) % time_.size(); }
+
+        void pop(void)
+        {
+            failed_count_ -= failed_[tail()];
+            count_--;
+        }
+
+        double                  window_;
+        double                  ratio_;
+        std::vector<double>     time_;          // ring buffer of sample times
+        std::vector<char>       failed_;        // ring buffer of sample results
+        unsigned int            head_;          // next slot to write
+        unsigned int            count_;         // samples in the buffer
+        unsigned int            failed_count_;  // failed samples in the buffer
+        bool                    stuck_;
+  };
+}
+
+#endif //! STUCK_DETECTOR_HH
@@ -0,0 +1,136 @@
+#include "team_behaviour.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <dlfcn.h>
+
+#define PI 3.14159265
+#define CM2M_CONVERSION 0.01
+#define M2CM_CONVERSION 100
+
+using namespace gazebo;
+
+BehaviourRegistry*  BehaviourRegistry::instance_ = NULL;
+boost::mutex        BehaviourRegistry::instance_lock_;
+
+static double degrees(double rad) { return rad*180.0/PI; }
+static double radians(double deg) { return deg*PI/180.0; }
+
+actuator_command ChaseDribble::on_perception(const team_snapshot & snapshot, unsigned int self)
+{
+    const robot_view & robot = snapshot.robots[self];
+    return decide(robot.ball_range, robot.ball_bearing, robot.right_goal_range, robot.right_goal_bearing, robot.holding);
+}
+
+actuator_command ChaseDribble::decide(double ball_range, double ball_bearing,
+                                      double goal_range, double goal_bearing, bool holding)
+{
+    // strategy.py; distances in cm and angles in degree as it reads them from OmniVisionInfo
+    const double goal_dis = goal_range * M2CM_CONVERSION;
+    const double goal_ang = degrees(goal_bearing);
+    const double ball_dis = ball_range * M2CM_CONVERSION;
+    const double ball_ang = degrees(ball_bearing);
+
+    double alpha = radians(ball_ang - goal_ang);
+    const double beta = 0.7;
+    alpha = std::max(-beta, std::min(beta, alpha));
+    const double br_x = ball_dis * cos(radians(ball_ang));
+    const double br_y = ball_dis * sin(radians(ball_ang));
+
+    double x, y;
+    if(holding)                                             // attack
+    {
+        x = goal_dis*2.8 * cos(radians(goal_ang));
+        y = goal_dis*2.8 * sin(radians(goal_ang));
+    }
+    else                                                    // chase
+    {
+        x = br_x*2.5 * cos(alpha) - br_y*2.5 * sin(alpha);
+        y = br_x*2.5 * sin(alpha) + br_y*2.5 * cos(alpha);
+    }
+
+    // Nubot_communication.pubNubotCtrl(): shape speed and turn rate
+    static const double dis_max = 2, dis_min = 0.3, velocity_max = 70, velocity_min = 50;
+    static const double angular_velocity_max = 2, angular_velocity_min = 0.5, angle_max = 144, angle_min = 20;
+    const double angle = goal_ang;
+    double velocity = sqrt(x*x + y*y);
+    const double heading = x != 0 ? atan2(y, x) : 0.0;
+    double angle_out = angle;
+
+    if(velocity == 0)
+        ;
+    else if(velocity > dis_max)
+        velocity = velocity_max;
+    else if(velocity < dis_min)
+        velocity = velocity_min;
+    else
+        velocity = (velocity_max - velocity_min) * (cos((((velocity - dis_min) / (dis_max-dis_min) - 1) * PI)) + 1)/2 + velocity_min;
+    if(angle == 0)
+        ;
+    else if(fabs(angle) > angle_max)
+        angle_out = angular_velocity_max;
+    else if(fabs(angle) < angle_min)
+        angle_out = angular_velocity_min;
+    else
+        angle_out = (angular_velocity_max - angular_velocity_min) * (cos((((angle - angle_min) / (angle_max-angle_min) - 1) * PI)) + 1)/2 + angular_velocity_min;
+    if(angle < 0)
+        angle_out = -angle_out;
+
+    actuator_command cmd;
+    cmd.Vx = velocity * cos(heading) * CM2M_CONVERSION;
+    cmd.Vy = velocity * sin(heading) * CM2M_CONVERSION;
+    cmd.w  = angle_out;
+    cmd.dribble = 1;                                        // ballhandle_client(1) every cycle
+    return cmd;
+}
+
+static TeamBehaviour* chase_dribble_factory(void)
+{
+    return new ChaseDribble();
+}
+
+BehaviourRegistry* BehaviourRegistry::Instance(void)
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    if(!instance_)
+        instance_ = new BehaviourRegistry();
+    return instance_;
+}
+
+BehaviourRegistry::BehaviourRegistry()
+{
+    // built in here rather than with NUBOT_REGISTER_BEHAVIOUR, so it does not depend on the order of static initialization
+    factories_["chase_dribble"] = &chase_dribble_factory;
+}
+
+void BehaviourRegistry::add(const std::string & name, behaviour_factory factory)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    factories_[name] = factory;
+}
+
+TeamBehaviour* BehaviourRegistry::create(const std::string & name)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    std::map<std::string, behaviour_factory>::iterator it = factories_.find(name);
+    return it != factories_.end() ? it->second() : NULL;
+}
+
+bool BehaviourRegistry::load(const std::string & path, std::string & error)
+{
+    // never closed: the factories and the code of the behaviours live in the library
+    if(dlopen(path.c_str(), RTLD_NOW | RTLD_GLOBAL))
+        return true;
+    const char * reason = dlerror();
+    error = reason ? reason : "unknown error";
+    return false;
+}
+
+std::vector<std::string> BehaviourRegistry::names(void)
+{
+    boost::mutex::scoped_lock lock(lock_);
+    std::vector<std::string> names;
+    for(std::map<std::string, behaviour_factory>::const_iterator it = factories_.begin(); it != factories_.end(); ++it)
+        names.push_back(it->first);
+    return names;
+}
@@ -0,0 +1,139 @@
+/* Desc: Behaviour plugin API of the team host (see nubot_team_host.hh). A behaviour controls one
+ *       robot; every control cycle it gets the team's view of the world and returns one actuator
+ *       command. Behaviours are created by name from the BehaviourRegistry; shared libraries
+ *       register theirs with NUBOT_REGISTER_BEHAVIOUR when they are loaded. Gazebo- and ROS-free.
+ */
+
+#ifndef TEAM_BEHAVIOUR_HH
+#define TEAM_BEHAVIOUR_HH
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace gazebo{
+   /// \brief One robot of the team as seen in a control cycle. Team frame: x points to the
+   /// attacked goal, as in the team's WorldModelInfo; the ego quantities are those of OmniVisionInfo.
+   struct robot_view
+   {
+       int      agent_id;
+       double   x, y, yaw;                  // m, rad
+       double   vx, vy, w;                  // m/s, rad/s
+       bool     valid;                      // inside the field
+       bool     stuck;
+       bool     holding;                    // the robot holds the football
+       double   ball_range, ball_bearing;   // football against the robot's heading (m, rad)
+       double   left_goal_range, left_goal_bearing;     // own goal, at -x
+       double   right_goal_range, right_goal_bearing;   // attacked goal, at +x
+   };
+
+   /// \brief Input of a control cycle, shared by all behaviours of the team
+   struct team_snapshot
+   {
+       uint64_t                 cycle;      // counts the control cycles of the host
+       double                   time;       // time of the world model (s)
+       double                   ball_x, ball_y, ball_vx, ball_vy;   // team frame (m, m/s)
+       std::vector<robot_view>  robots;     // teammates, ordered as in WorldModelInfo
+       std::vector<double>      opponent_x, opponent_y;
+   };
+
+   /// \brief Output of a behaviour; the fields of nubot_common/ActuatorCmd in ISO units
+   struct actuator_command
+   {
+       double   Vx, Vy, w;                  // m/s, rad/s, in the frame of nubotcontrol/velcmd
+       int      dribble;                    // as BallHandle.enable; 0 stops dribbling
+       bool     shoot;                      // send a Shoot request with the two fields below
+       double   strength;
+       int      shoot_pos;
+
+       actuator_command() : Vx(0.0), Vy(0.0), w(0.0), dribble(0), shoot(false), strength(0.0), shoot_pos(0) {}
+   };
+
+  /// \class TeamBehaviour
+  /// \brief Controller of one robot, run by the team host. on_perception() of different robots
+  /// runs concurrently on different threads; one behaviour is never called concurrently.
+  class TeamBehaviour
+  {
+    public:
+        virtual ~TeamBehaviour() {}
+
+        /// \brief Called once before the first cycle
+        /// \param[in] agent_id     id of the controlled robot
+        /// \param[in] magenta      the robot belongs to the magenta (rival) team
+        virtual void configure(int /*agent_id*/, bool /*magenta*/) {}
+
+        /// \brief Decide the command of this cycle
+        /// \param[in] snapshot     the team's view of the world
+        /// \param[in] self         index of the controlled robot in snapshot.robots
+        virtual actuator_command on_perception(const team_snapshot & snapshot, unsigned int self) = 0;
+  };
+
+  /// \class ChaseDribble
+  /// \brief The policy of strategy/strategy.py: chase the ball facing the attacked goal, and
+  /// dribble it towards the goal once held. Also played by every robot of the match runner.
+  class ChaseDribble : public TeamBehaviour
+  {
+    public:
+        virtual actuator_command on_perception(const team_snapshot & snapshot, unsigned int self);
+
+        /// \brief The policy on the quantities strategy.py reads from OmniVisionInfo and BallHandle
+        /// \param[in] ball_range, ball_bearing     football against the heading (m, rad)
+        /// \param[in] goal_range, goal_bearing     attacked goal against the heading (m, rad)
+        /// \param[in] holding                      the robot holds the football
+        static actuator_command decide(double ball_range, double ball_bearing,
+                                       double goal_range, double goal_bearing, bool holding);
+  };
+
+  typedef TeamBehaviour* (*behaviour_factory)(void);
+
+  /// \class BehaviourRegistry
+  /// \brief Process-wide map from behaviour names to factories; "chase_dribble" is built in
+  class BehaviourRegistry
+  {
+    public:
+        /// \brief Get the process-wide registry. It is created by the first caller.
+        static BehaviourRegistry* Instance(void);
+
+        /// \brief Register a factory; a later registration of the same name replaces it
+        void add(const std::string & name, behaviour_factory factory);
+
+        /// \brief Create a behaviour
+        /// \return NULL if no behaviour of this name has been registered
+        TeamBehaviour* create(const std::string & name);
+
+        /// \brief Load a shared library; its NUBOT_REGISTER_BEHAVIOUR entries register themselves
+        /// \param[out] error       reason if the library could not be loaded
+        bool load(const std::string & path, std::string & error);
+
+        /// \brief Names of all registered behaviours
+        std::vector<std::string> names(void);
+
+    private:
+        BehaviourRegistry();
+
+        static BehaviourRegistry*   instance_;
+        static boost::mutex         instance_lock_;
+
+        boost::mutex                lock_;
+        std::map<std::string, behaviour_factory> factories_;
+  };
+
+  /// \brief Registers a behaviour at load time, see NUBOT_REGISTER_BEHAVIOUR
+  struct behaviour_registrar
+  {
+      behaviour_registrar(const char * name, behaviour_factory factory)
+      {
+          BehaviourRegistry::Instance()->add(name, factory);
+      }
+  };
+}
+
+/// \brief Register a TeamBehaviour subclass under a name, in the style of GZ_REGISTER_MODEL_PLUGIN;
+/// put it in the source file of the behaviour
+#define NUBOT_REGISTER_BEHAVIOUR(name, classname) \
+  static gazebo::TeamBehaviour* classname##_factory(void) { return new classname(); } \
+  static gazebo::behaviour_registrar classname##_registrar(name, &classname##_factory);
+
+#endif //! TEAM_BEHAVIOUR_HH
@@ -0,0 +1,216 @@
+#include "team_spawner.hh"
+#include "field_layout.hh"
+#include "formation.hh"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace gazebo;
+GZ_REGISTER_WORLD_PLUGIN(TeamSpawner)
+
+// model frame pose of the visual of the template, as in nubot1: chassis at 0.3, visual at -0.68 in it
+static const math::Pose VISUAL_POSE(0.0, 0.04, -0.38, 0.0, 0.0, 1.57);
+
+TeamSpawner::TeamSpawner()
+{}
+
+TeamSpawner::~TeamSpawner()
+{
+    if(update_connection_)
+        event::Events::DisconnectWorldUpdateBegin(update_connection_);
+}
+
+bool TeamSpawner::read_file(const std::string & path, std::string & content)
+{
+    std::ifstream file(path.c_str());
+    if(!file)
+        return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+bool TeamSpawner::read_body(const std::string & path, robot_body & body)
+{
+    sdf::SDFPtr model_sdf(new sdf::SDF());
+    sdf::init(model_sdf);
+    if(!sdf::readFile(path, model_sdf) || !model_sdf->root->HasElement("model"))
+        return false;
+    sdf::ElementPtr link = model_sdf->root->GetElement("model")->GetElement("link");
+    if(!link->HasElement("collision") || !link->GetElement("collision")->HasElement("geometry"))
+        return false;
+
+    const math::Pose chassis = link->Get<math::Pose>("pose");
+    std::ostringstream chassis_pose, visual_pose;
+    chassis_pose << chassis;
+    visual_pose << VISUAL_POSE - chassis;
+    body.chassis_pose = chassis_pose.str();
+    body.visual_pose = visual_pose.str();
+    body.collision_geometry = link->GetElement("collision")->GetElement("geometry")->ToString("");
+    return true;
+}
+
+void TeamSpawner::replace(std::string & text, const std::string & placeholder, const std::string & value)
+{
+    for(size_t pos = text.find(placeholder); pos != std::string::npos; pos = text.find(placeholder, pos + value.size()))
+        text.replace(pos, placeholder.size(), value);
+}
+
+std::string TeamSpawner::static_include(const std::string & uri, const std::string & name,
+                                        double x, double y, double z, double yaw)
+{
+    std::ostringstream sdf;
+    sdf << "<sdf version='1.4'><include><uri>model://" << uri << "</uri><name>" << name << "</name>"
+        << "<pose>" << x << " " << y << " " << z << " 0 0 " << yaw << "</pose><static>true</static></include></sdf>";
+    return sdf.str();
+}
+
+void TeamSpawner::Load(physics::WorldPtr _world, sdf::ElementPtr /*_sdf*/)
+{
+    world_ = _world;
+    start_time_ = common::Time::GetWallTime();
+
+    if (!ros::isInitialized())
+    {
+        ROS_FATAL_STREAM("A ROS node for Gazebo has not been initialized, unable to load plugin. "
+                         << "Load the Gazebo system plugin 'libgazebo_ros_api_plugin.so' in the gazebo_ros package)");
+        return;
+    }
+    ros::NodeHandle rosnode;
+    bool enable;
+    rosnode.param<bool>("/spawner/enable", enable, false);
+    if(!enable)
+        return;
+
+    std::string template_path, football_path, models_path, football_name, cyan_pre, mag_pre;
+    int cyan_num, magenta_num, field_num;
+    double field_spacing, field_length;
+    std::vector<std::string> cyan_colours, magenta_colours, cyan_bodies, magenta_bodies;
+    rosnode.param<std::string>("/spawner/template",         template_path,  std::string(""));
+    rosnode.param<std::string>("/spawner/football_model",   football_path,  std::string(""));
+    rosnode.param<std::string>("/spawner/models",           models_path,    std::string(""));
+    rosnode.param<std::string>("/football/name",            football_name,  std::string("football"));
+    rosnode.param<std::string>("/cyan/prefix",              cyan_pre,       std::string("nubot"));
+    rosnode.param<std::string>("/magenta/prefix",           mag_pre,        std::string("rival"));
+    rosnode.param<int>("/cyan/num",                         cyan_num,       3);
+    rosnode.param<int>("/magenta/num",                      magenta_num,    3);
+    rosnode.param<int>("/fields/num",                       field_num,      1);
+    rosnode.param<double>("/fields/spacing",                field_spacing,  20.0);
+    rosnode.param<double>("/field/length",                  field_length,   18.0);
+    if(!rosnode.getParam("/spawner/cyan_colours", cyan_colours) || cyan_colours.empty())
+        cyan_colours.assign(1, "Gazebo/Black");
+    if(!rosnode.getParam("/spawner/magenta_colours", magenta_colours) || magenta_colours.empty())
+        magenta_colours.assign(1, "Gazebo/Purple");
+    if(!rosnode.getParam("/spawner/cyan_bodies", cyan_bodies) || cyan_bodies.empty())
+        cyan_bodies.assign(1, "nubot1");
+    if(!rosnode.getParam("/spawner/magenta_bodies", magenta_bodies) || magenta_bodies.empty())
+        magenta_bodies.assign(1, "rival1");
+
+    // each file is read and parsed once, however many robots and fields there are
+    std::string robot_template, football_template;
+    if(!read_file(template_path, robot_template))
+    {
+        ROS_ERROR("TeamSpawner: cannot read the robot template [%s]", template_path.c_str());
+        return;
+    }
+    if(!read_file(football_path, football_template))
+    {
+        ROS_ERROR("TeamSpawner: cannot read the football model [%s]", football_path.c_str());
+        return;
+    }
+    const std::string football_tag = "<model name=\"football\">";
+    size_t football_pos = football_template.find(football_tag);
+    if(football_pos != std::string::npos)
+        football_template.replace(football_pos, football_tag.size(), "<model name=\"@NAME@\">");
+
+    std::map<std::string, robot_body> bodies;
+    for(int team=0; team<2; team++)
+    {
+        const std::vector<std::string> & names = team == 1 ? magenta_bodies : cyan_bodies;
+        for(unsigned int i=0; i<names.size(); i++)
+        {
+            const std::string path = models_path + "/" + names[i] + "/model.sdf";
+            if(!bodies.count(names[i]) && !read_body(path, bodies[names[i]]))
+            {
+                ROS_ERROR("TeamSpawner: cannot read the chassis of the robot model [%s]", path.c_str());
+                return;
+            }
+        }
+    }
+
+    for(int field=0; field<field_num; field++)
+    {
+        const std::string prefix = field_prefix(field);
+        const double origin_y = field * field_spacing;
+
+        // the first field and its goals are part of the world file
+        if(field > 0)
+        {
+            world_->InsertModelString(static_include("RoboCup15_MSL_Field", prefix + "field", 0.0, origin_y, 0.0, 0.0));
+            world_->InsertModelString(static_include("RoboCup15_MSL_Goal", prefix + "left_goal",
+                                                     -field_length/2.0, origin_y, 0.01, -3.14));
+            world_->InsertModelString(static_include("RoboCup15_MSL_Goal", prefix + "right_goal",
+                                                     field_length/2.0, origin_y, 0.01, 0.0));
+        }
+
+        std::string football = football_template;
+        replace(football, "@NAME@", prefix + football_name);
+        world_->InsertModelString(football);
+        pending_.push_back(prefix + football_name);
+
+        for(int team=0; team<2; team++)
+        {
+            const bool magenta = team == 1;
+            const int num = magenta ? magenta_num : cyan_num;
+            const std::vector<std::string> & colours = magenta ? magenta_colours : cyan_colours;
+            const std::vector<std::string> & body_names = magenta ? magenta_bodies : cyan_bodies;
+            for(int id=1; id<=num; id++)
+            {
+                // the formation of robot_up.sh; robots it has no place for line up at the side line
+                double x, y;
+                if(!formation_position(magenta, id, x, y))
+                {
+                    x = (magenta ? 1 : -1) * 0.6 * id;
+                    y = -6.0;
+                }
+                std::ostringstream name, pose;
+                name << prefix << (magenta ? mag_pre : cyan_pre) << id;
+                pose << x << " " << y + origin_y << " 0 0 0 0";
+
+                const robot_body & body = bodies[body_names[(id - 1) % body_names.size()]];
+                std::string robot = robot_template;
+                replace(robot, "@NAME@",               name.str());
+                replace(robot, "@POSE@",               pose.str());
+                replace(robot, "@MATERIAL@",           colours[(id - 1) % colours.size()]);
+                replace(robot, "@FLIP_CORD@",          magenta ? "1" : "0");
+                replace(robot, "@CHASSIS_POSE@",       body.chassis_pose);
+                replace(robot, "@COLLISION_GEOMETRY@", body.collision_geometry);
+                replace(robot, "@VISUAL_POSE@",        body.visual_pose);
+                world_->InsertModelString(robot);
+                pending_.push_back(name.str());
+            }
+        }
+    }
+    ROS_INFO("TeamSpawner: %d models of %d fields inserted in %.3f s", (int)pending_.size(), field_num,
+             (common::Time::GetWallTime() - start_time_).Double());
+
+    // the world loads the inserted models in its next update
+    update_connection_ = event::Events::ConnectWorldUpdateBegin(
+                boost::bind(&TeamSpawner::update, this));
+}
+
+void TeamSpawner::update(void)
+{
+    while(!pending_.empty() && world_->GetModel(pending_.back()))
+        pending_.pop_back();
+    if(!pending_.empty())
+        return;
+
+    double startup_time = (common::Time::GetWallTime() - start_time_).Double();
+    ros::param::set("/spawner/startup_time", startup_time);
+    ROS_INFO("TeamSpawner: all models spawned, startup took %.3f s", startup_time);
+    event::Events::DisconnectWorldUpdateBegin(update_connection_);
+    update_connection_.reset();
+}
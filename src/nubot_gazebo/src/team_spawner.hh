@@ -0,0 +1,67 @@
+#ifndef TEAM_SPAWNER_HH
+#define TEAM_SPAWNER_HH
+
+#include <gazebo/gazebo.hh>             // the core gazebo header files, including gazebo/math/gzmath.hh
+#include <gazebo/physics/physics.hh>
+#include <gazebo/common/common.hh>
+#include <gazebo/common/Plugin.hh>
+#include <gazebo/common/Events.hh>
+
+#include <ros/ros.h>
+
+#include <string>
+#include <vector>
+
+namespace gazebo{
+  /// \brief What a robot model gives the template: its chassis and its collision geometry
+  struct robot_body
+  {
+      std::string   chassis_pose;                       // "x y z roll pitch yaw" of the chassis link
+      std::string   collision_geometry;                 // <geometry> element of the chassis collision
+      std::string   visual_pose;                        // of the template visual, in the chassis frame
+  };
+
+  /// \class TeamSpawner
+  /// \brief Spawns the football and all robots of all fields from inside gzserver, replacing the
+  /// serial spawn_model calls of robot_up.sh. The robot SDF template (parameter /spawner/template)
+  /// is read once; every robot is instantiated from it with its name, start pose, colour and
+  /// flip_cord filled in, and with the chassis pose and collision geometry of its own model in
+  /// /spawner/models, and all models are handed to the world in one pass. The time from
+  /// loading the plugin until every robot plugin is running is logged and stored in the
+  /// parameter /spawner/startup_time. Enabled with the parameter /spawner/enable.
+  class TeamSpawner : public WorldPlugin
+  {
+    public:
+        TeamSpawner();
+        virtual ~TeamSpawner();
+
+        /// \brief Read the templates and insert all models. Called when the world is loaded.
+        void Load(physics::WorldPtr _world, sdf::ElementPtr _sdf);
+
+    private:
+        /// \brief Wait until all spawned models are in the world, then report the startup time
+        void update(void);
+
+        /// \brief Read a whole file
+        /// \return false if the file cannot be read
+        static bool read_file(const std::string & path, std::string & content);
+
+        /// \brief Read the chassis of a robot model, e.g. models/nubot1/model.sdf
+        /// \return false if the file cannot be read or has no chassis collision
+        static bool read_body(const std::string & path, robot_body & body);
+
+        /// \brief SDF of a static model from the model database, e.g. the field of a second match
+        static std::string static_include(const std::string & uri, const std::string & name,
+                                          double x, double y, double z, double yaw);
+
+        /// \brief Replace every occurrence of a placeholder
+        static void replace(std::string & text, const std::string & placeholder, const std::string & value);
+
+        physics::WorldPtr           world_;
+        event::ConnectionPtr        update_connection_;
+        std::vector<std::string>    pending_;           // spawned models that are not in the world yet
+        common::Time                start_time_;        // wall time the plugin was loaded at
+  };
+}
+
+#endif //! TEAM_SPAWNER_HH
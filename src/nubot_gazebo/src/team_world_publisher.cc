@@ -0,0 +1,75 @@
+#include "team_world_publisher.hh"
+#include "alloc_counter.hh"
+
+using namespace gazebo;
+
+std::map<int, TeamWorldPublisher*> TeamWorldPublisher::instances_;
+boost::mutex        TeamWorldPublisher::instance_lock_;
+
+TeamWorldPublisher* TeamWorldPublisher::Instance(int field, const std::string & field_ns, int team, double rate)
+{
+    if(team != CYAN_TEAM && team != MAGENTA_TEAM)
+        return NULL;
+
+    boost::mutex::scoped_lock lock(instance_lock_);
+    TeamWorldPublisher* & instance = instances_[field * 2 + team];
+    if(!instance)
+        instance = new TeamWorldPublisher(field_ns, team, rate);
+    return instance;
+}
+
+TeamWorldPublisher::TeamWorldPublisher(const std::string & field_ns, int team, double rate)
+    : team_(team), rosnode_(field_ns + (team == CYAN_TEAM ? "/cyan" : "/magenta")),
+      stats_(PluginStats::Instance()), last_iteration_(0), version_(0)
+{
+    world_model_pub_ = rosnode_.advertise<nubot_common::WorldModelInfo>("worldmodel/WorldModelInfo", 10);
+    scheduler_.configure(rate, 0.0, 0.0);
+    world_model_.ballinfo.resize(1);
+    layout_.magenta = team == MAGENTA_TEAM;
+    ROS_INFO("TeamWorldPublisher: publishing %s/worldmodel/WorldModelInfo at %.1f Hz",
+             rosnode_.getNamespace().c_str(), rate);
+}
+
+void TeamWorldPublisher::resize(const WorldSnapshot & snapshot)
+{
+    const std::vector<model_record> & records = *snapshot.records;
+    layout_.teammates.clear();
+    layout_.agent_ids.clear();
+    layout_.opponents.clear();
+    for(unsigned int i=0; i<records.size(); i++)
+        if(records[i].kind == ROBOT_MODEL)
+        {
+            if(records[i].team == team_)
+            {
+                layout_.teammates.push_back(i);
+                layout_.agent_ids.push_back(records[i].agent_id);
+            }
+            else
+                layout_.opponents.push_back(i);
+        }
+    world_model_.robotinfo.resize(layout_.teammates.size());
+    world_model_.oppinfo.pos.resize(layout_.opponents.size());
+    version_ = snapshot.version;
+}
+
+void TeamWorldPublisher::update(const WorldSnapshot & snapshot, unsigned long & publish_allocations)
+{
+    // the first robot of the team to get here in this iteration does the work
+    if(snapshot.iteration == last_iteration_)
+        return;
+    last_iteration_ = snapshot.iteration;
+
+    if(snapshot.ball_index < 0 || !scheduler_.should_publish(snapshot.sim_time.Double()))
+        return;
+    if(snapshot.version != version_)
+        resize(snapshot);
+
+    fill_team_world_model(snapshot.states, layout_, snapshot.stuck, snapshot.ball_index, snapshot.ball_holder,
+                          ros::Time::now(), world_model_);
+
+    // roscpp serializes the message into a buffer of its own; not counted as our allocation
+    unsigned long allocations = allocation_count();
+    world_model_pub_.publish(world_model_);
+    publish_allocations += allocation_count() - allocations;
+    stats_->count(COUNT_TEAM_WORLD);
+}
@@ -0,0 +1,64 @@
+#ifndef TEAM_WORLD_PUBLISHER_HH
+#define TEAM_WORLD_PUBLISHER_HH
+
+#include <ros/ros.h>
+#include <nubot_common/WorldModelInfo.h>
+
+#include "world_state.hh"
+#include "robot_messages.hh"
+#include "publish_scheduler.hh"
+#include "plugin_stats.hh"
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <stdint.h>
+#include <string>
+
+namespace gazebo{
+  /// \class TeamWorldPublisher
+  /// \brief Publishes one WorldModelInfo per team per publish slot, built from the shared
+  /// WorldSnapshot. Teammate and opponent lists are thus serialized once per team instead of
+  /// once per robot inside every OmniVisionInfo.
+  /// Reference frame: the team's own, i.e. x, y, vx and vy are negated for the magenta team.
+  /// Length unit is cm, as in all other messages. With several fields in the world there is one
+  /// publisher per team and field, under the field's namespace, e.g. /field2/cyan.
+  class TeamWorldPublisher
+  {
+    public:
+        /// \brief Get the publisher of a team. It is created by the first caller.
+        /// \param[in] field        field number, 0 if the world has a single field
+        /// \param[in] field_ns     ROS namespace prefix of the field, empty for field 0
+        /// \param[in] team         CYAN_TEAM or MAGENTA_TEAM
+        /// \param[in] rate         publish rate in Hz of simulated time; only used by the first caller
+        static TeamWorldPublisher* Instance(int field, const std::string & field_ns, int team, double rate);
+
+        /// \brief Publish the team's world model if this step is in a new publish slot.
+        /// Every robot of the team calls it every step; only the first call in a world iteration
+        /// does any work. Must be called from the physics thread.
+        /// \param[in] snapshot     world snapshot of the current iteration
+        /// \param[in,out] publish_allocations    heap allocations of roscpp's publish() are added to it
+        void update(const WorldSnapshot & snapshot, unsigned long & publish_allocations);
+
+    private:
+        TeamWorldPublisher(const std::string & field_ns, int team, double rate);
+
+        /// \brief Find the teammates and opponents and size the message arrays after models have
+        /// been added or removed
+        void resize(const WorldSnapshot & snapshot);
+
+        static std::map<int, TeamWorldPublisher*> instances_;  // key: field * 2 + team
+        static boost::mutex         instance_lock_;
+
+        int                         team_;
+        ros::NodeHandle             rosnode_;
+        ros::Publisher              world_model_pub_;
+        PublishScheduler            scheduler_;
+        PluginStats*                stats_;
+        team_world_layout           layout_;            // robots of the message; found on registry changes
+        nubot_common::WorldModelInfo world_model_;     // filled in place; sized on registry changes
+        uint64_t                    last_iteration_;    // world iteration of the last update
+        unsigned int                version_;           // registry version the message is sized for
+  };
+}
+
+#endif //! TEAM_WORLD_PUBLISHER_HH
@@ -0,0 +1,49 @@
+#ifndef TRIPLE_BUFFER_HH
+#define TRIPLE_BUFFER_HH
+
+#include <atomic>
+
+namespace gazebo{
+  /// \class TripleBuffer
+  /// \brief Wait-free exchange of the latest value between one writer thread and one reader thread.
+  /// The writer fills write_buffer() and calls publish(); the reader calls update() and then reads
+  /// read_buffer(). Neither side ever blocks, and the reader always sees a complete value.
+  template<typename T> class TripleBuffer
+  {
+    public:
+        TripleBuffer() : buffers_(), back_(0), middle_(1), front_(2) {}
+
+        /// \brief Buffer owned by the writer
+        T & write_buffer(void) { return buffers_[back_]; }
+
+        /// \brief Hand the write buffer over to the reader. Writer side only.
+        void publish(void)
+        {
+            back_ = middle_.exchange(back_ | DIRTY, std::memory_order_acq_rel) & INDEX;
+        }
+
+        /// \brief Take the latest published value if there is one. Reader side only.
+        /// \return true if a new value has been published since the last update
+        bool update(void)
+        {
+            if(!(middle_.load(std::memory_order_acquire) & DIRTY))
+                return false;
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX;
+            return true;
+        }
+
+        /// \brief Buffer owned by the reader; the value taken by the last successful update()
+        const T & read_buffer(void) const { return buffers_[front_]; }
+
+    private:
+        static const int INDEX = 3;                 // mask of the buffer index
+        static const int DIRTY = 4;                 // the middle buffer holds a value not read yet
+
+        T                   buffers_[3];
+        int                 back_;                  // written by the writer only
+        std::atomic<int>    middle_;                // exchanged by both sides
+        int                 front_;                 // read by the reader only
+  };
+}
+
+#endif //! TRIPLE_BUFFER_HH
@@ -17,6 +17,7 @@
 
 /* Desc: As an extension to the operation of gazebo::math::Vector3
  *       Calculate angles between two vectors both used for planar and spatial vectors
+ *       For planar vectors in per-step code, use planar_angle()/planar_bearings() in planar_angle.hh
  * Author: Weijia Yao
  * Date: Jun 2015
  */
@@ -26,6 +27,7 @@
 
 #include <gazebo/gazebo.hh>     // the core gazebo header files, including gazebo/math/gzmath.hh
 #include <math.h>
+#include "planar_angle.hh"
 #define PI 3.14159265
 using namespace gazebo;
 
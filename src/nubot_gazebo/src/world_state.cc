@@ -0,0 +1,123 @@
+#include "world_state.hh"
+
+using namespace gazebo;
+
+std::map<int, WorldStateCache*> WorldStateCache::instances_;
+boost::mutex        WorldStateCache::instance_lock_;
+
+WorldStateCache* WorldStateCache::Instance(physics::WorldPtr world, int field, double origin_x, double origin_y,
+                                           const std::string & cyan_pre, const std::string & mag_pre,
+                                           const std::string & ball_name, const std::string goal_names[2])
+{
+    boost::mutex::scoped_lock lock(instance_lock_);
+    WorldStateCache* & instance = instances_[field];
+    if(!instance)
+        instance = new WorldStateCache(world, origin_x, origin_y, cyan_pre, mag_pre, ball_name, goal_names);
+    return instance;
+}
+
+WorldStateCache::WorldStateCache(physics::WorldPtr world, double origin_x, double origin_y, const std::string & cyan_pre,
+                                 const std::string & mag_pre, const std::string & ball_name,
+                                 const std::string goal_names[2])
+    : world_(world), origin_x_(origin_x), origin_y_(origin_y),
+      registry_(cyan_pre, mag_pre, ball_name), valid_(false)
+{
+    goal_names_[0] = goal_names[0];
+    goal_names_[1] = goal_names[1];
+    snapshot_.goals.known = false;
+    snapshot_.goals.left_x = snapshot_.goals.left_y = snapshot_.goals.right_x = snapshot_.goals.right_y = 0.0;
+    snapshot_.iteration = 0;
+    snapshot_.ball_index = -1;
+    snapshot_.ball_holder = -1;
+    snapshot_.version = 0;
+    snapshot_.records = &registry_.records();
+    snapshot_.names = &registry_.names();
+    snapshot_.states.reserve(20);
+
+    ParamStore* params = ParamStore::Instance();
+    distance_thres_  = params->declare("/general/dribble_distance_thres",     0.50);
+    angle_thres_     = params->declare("/general/dribble_angle_thres",        30.0);
+    distance_margin_ = params->declare("/general/possession_distance_margin", 0.05);
+    angle_margin_    = params->declare("/general/possession_angle_margin",    5.0);
+}
+
+const WorldSnapshot & WorldStateCache::snapshot(void)
+{
+    if(!valid_ || snapshot_.iteration != world_->GetIterations())
+        refresh();
+    return snapshot_;
+}
+
+void WorldStateCache::find_goals(void)
+{
+    // the goals are static models; their positions are taken once, in the field's frame
+    physics::ModelPtr left  = world_->GetModel(goal_names_[0]);
+    physics::ModelPtr right = world_->GetModel(goal_names_[1]);
+    snapshot_.goals.known = left && right;
+    if(!snapshot_.goals.known)
+        return;
+    math::Vector3 left_pos  = left->GetWorldPose().pos;
+    math::Vector3 right_pos = right->GetWorldPose().pos;
+    snapshot_.goals.left_x  = left_pos.x - origin_x_;
+    snapshot_.goals.left_y  = left_pos.y - origin_y_;
+    snapshot_.goals.right_x = right_pos.x - origin_x_;
+    snapshot_.goals.right_y = right_pos.y - origin_y_;
+}
+
+void WorldStateCache::refresh(void)
+{
+    snapshot_.iteration = world_->GetIterations();
+    snapshot_.sim_time  = world_->GetSimTime();
+
+    // model names are only looked at when models are added or removed
+    if(registry_.update(world_))
+    {
+        snapshot_.states.resize(registry_.records().size());
+        snapshot_.stuck.assign(registry_.records().size(), false);
+        snapshot_.ball_index = registry_.ball_index();
+        snapshot_.version    = registry_.version();
+
+        // the team is the tie break before the id, so the result does not depend on the world's model order
+        const std::vector<model_record> & records = registry_.records();
+        agents_.resize(records.size());
+        for(unsigned int i=0; i<records.size(); i++)
+        {
+            agents_[i].robot   = records[i].kind == ROBOT_MODEL;
+            agents_[i].flipped = records[i].team == MAGENTA_TEAM;
+            agents_[i].rank    = records[i].team * 1000 + records[i].agent_id;
+        }
+        possession_.set_agents(agents_);
+        find_goals();
+    }
+
+    // the same quantities gazebo_ros publishes in /gazebo/model_states, reduced to the plane
+    // and moved to the field's own frame
+    const std::vector<physics::ModelPtr> & models = registry_.models();
+    PlanarStates & states = snapshot_.states;
+    for(unsigned int i=0; i<models.size(); i++)
+    {
+        math::Pose    pose = models[i]->GetWorldPose();
+        math::Vector3 vel  = models[i]->GetWorldLinearVel();
+        states.x[i]   = pose.pos.x - origin_x_;
+        states.y[i]   = pose.pos.y - origin_y_;
+        states.yaw[i] = pose.rot.GetYaw();
+        states.vx[i]  = vel.x;
+        states.vy[i]  = vel.y;
+        states.w[i]   = models[i]->GetWorldAngularVel().z;
+    }
+    if(snapshot_.ball_index >= 0)
+    {
+        physics::ModelPtr ball = models[snapshot_.ball_index];
+        states.ball_z  = ball->GetWorldPose().pos.z;
+        states.ball_vz = ball->GetWorldLinearVel().z;
+        transform_ball_to_egos(states, snapshot_.ball_index, snapshot_.ball_relative);
+
+        // one holder for the whole field; the robot plugins and their services only read it
+        possession_.set_params(distance_thres_->get(), angle_thres_->get(),
+                               distance_margin_->get(), angle_margin_->get());
+        snapshot_.ball_holder = possession_.update(snapshot_.ball_relative);
+    }
+    else
+        snapshot_.ball_holder = -1;
+    valid_ = true;
+}
@@ -0,0 +1,117 @@
+#ifndef WORLD_STATE_HH
+#define WORLD_STATE_HH
+
+#include <gazebo/gazebo.hh>             // the core gazebo header files, including gazebo/math/gzmath.hh
+#include <gazebo/physics/physics.hh>
+#include <gazebo/common/common.hh>
+
+#include "model_registry.hh"
+#include "planar_state.hh"
+#include "ball_possession.hh"
+#include "param_store.hh"
+
+#include <boost/thread/mutex.hpp>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace gazebo{
+   /// \brief Goals of a field, in the field frame
+   struct goal_positions
+   {
+       bool   known;                // both goal models are in the world
+       double left_x, left_y;       // center of the goal at -x (m)
+       double right_x, right_y;     // center of the goal at +x (m)
+   };
+
+   /// \brief States of the robots and the football of one field taken directly from physics::World.
+   /// Reference frame: the field, i.e. the world frame shifted to the field's origin; the same as
+   /// the world frame for field 0. No noise and no coordinate flipping is applied here.
+   struct WorldSnapshot
+   {
+       uint64_t                    iteration;      // world iteration the snapshot was taken at
+       common::Time                sim_time;       // simulation time the snapshot was taken at
+       PlanarStates                states;         // robots and the football, structure of arrays
+       EgoStates                   ball_relative;  // football relative to every agent; noise free
+       const std::vector<model_record> * records;  // roles of models; records->at(i) belongs to entry i of states
+       const std::vector<std::string> *  names;    // model names; only for look-ups when version changes
+       std::vector<char>           stuck;          // stuck flags reported by the robot plugins; a robot updated
+                                                   // later in the iteration still shows its previous flag
+       int                         ball_index;     // index of the football in states; -1 if not spawned yet
+       int                         ball_holder;    // index of the robot holding the football; -1 if none.
+                                                   // Decided once per step for the whole field, see BallPossession
+       goal_positions              goals;          // static; looked up when models are added or removed
+       unsigned int                version;        // registry version; indices are only valid within one version
+   };
+
+  /// \class WorldStateCache
+  /// \brief World state shared by all robot plugins of a field in the gzserver process.
+  /// The snapshot is filled at most once per physics step straight from physics::World,
+  /// so robot plugins do not have to subscribe to /gazebo/model_states. There is one cache
+  /// per field; each only tracks the models of its own field, see field_layout.hh.
+  class WorldStateCache
+  {
+    public:
+        /// \brief Get the cache of a field. The cache is created by the first caller of the field.
+        /// \param[in] world        the gazebo world
+        /// \param[in] field        field number; 0 if the world has a single field
+        /// \param[in] origin_x, origin_y   center of the field in the world frame (m)
+        /// \param[in] cyan_pre     cyan robot model name prefix, including the field prefix
+        /// \param[in] mag_pre      magenta robot model name prefix, including the field prefix
+        /// \param[in] ball_name    football model name, including the field prefix
+        /// \param[in] goal_names   names of the goal models at -x and +x, including the field prefix
+        static WorldStateCache* Instance(physics::WorldPtr world, int field, double origin_x, double origin_y,
+                                         const std::string & cyan_pre, const std::string & mag_pre,
+                                         const std::string & ball_name, const std::string goal_names[2]);
+
+        /// \brief Get the snapshot of the current world iteration. Refreshes the snapshot if it is
+        /// older than the current iteration. Must be called from the physics thread.
+        /// \return const reference to the snapshot; valid until the next call
+        const WorldSnapshot & snapshot(void);
+
+        /// \brief Get the role of a model from its name. Used once at load time.
+        /// \param[in]  name    model name
+        /// \param[out] record  role of the model
+        /// \return false if the model is neither a robot nor the football
+        bool parse(const std::string & name, model_record & record) const { return registry_.parse(name, record); }
+
+        /// \brief Report the stuck flag of a robot, computed once per step by its plugin
+        /// \param[in] index    index of the robot in the snapshot
+        /// \param[in] stuck    whether the robot is stuck
+        void set_stuck(int index, bool stuck)
+        {
+            if(index >= 0 && index < (int)snapshot_.stuck.size())
+                snapshot_.stuck[index] = stuck;
+        }
+
+    private:
+        WorldStateCache(physics::WorldPtr world, double origin_x, double origin_y, const std::string & cyan_pre,
+                        const std::string & mag_pre, const std::string & ball_name, const std::string goal_names[2]);
+
+        /// \brief Look up the goal models; called when models are added or removed
+        void find_goals(void);
+
+        /// \brief Fill the snapshot from physics::World
+        void refresh(void);
+
+        static std::map<int, WorldStateCache*>  instances_;     // one per field
+        static boost::mutex         instance_lock_;
+
+        physics::WorldPtr           world_;
+        double                      origin_x_;          // center of the field in the world frame
+        double                      origin_y_;
+        WorldSnapshot               snapshot_;
+        ModelRegistry               registry_;
+        std::string                 goal_names_[2];     // left (-x) and right (+x) goal models
+        BallPossession              possession_;
+        std::vector<possession_agent> agents_;          // possession roles of the registry's records
+        const ParamValue*           distance_thres_;    // /general/dribble_distance_thres (m)
+        const ParamValue*           angle_thres_;       // /general/dribble_angle_thres (degree)
+        const ParamValue*           distance_margin_;   // /general/possession_distance_margin (m)
+        const ParamValue*           angle_margin_;      // /general/possession_angle_margin (degree)
+        bool                        valid_;             // snapshot has been filled at least once
+  };
+}
+
+#endif //! WORLD_STATE_HH
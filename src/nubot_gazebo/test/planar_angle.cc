@@ -0,0 +1,192 @@
+/* Desc: accuracy of the planar angle kernels of src/planar_angle.hh against std::atan2 and
+ *       the normalize/dot/cross/acos chain of get_angle_PI() they replace.
+ * Usage: catkin_make run_tests_nubot_gazebo
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "planar_angle.hh"
+#include "vector_angle_reference.hh"
+
+using namespace gazebo;
+
+static const double         MAX_ERROR = 2e-8;          // rad, as documented for fast_atan2()
+static const unsigned int   SAMPLES = 1000000;
+
+/// \brief Distance of two angles on the circle, so that PI and -PI are the same angle
+static double angle_distance(double a, double b)
+{
+    return std::fabs(std::remainder(a - b, 2*M_PI));
+}
+
+TEST(PlanarAngle, FastAtan2MatchesAtan2)
+{
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    std::uniform_real_distribution<double> exponent(-6.0, 6.0);
+    double max_error = 0.0;
+    for(unsigned int i=0; i<SAMPLES; i++)
+    {
+        const double scale = std::pow(10.0, exponent(rng));
+        const double y = coordinate(rng) * scale;
+        const double x = coordinate(rng) * scale;
+        max_error = std::max(max_error, std::fabs(fast_atan2(y, x) - std::atan2(y, x)));
+    }
+    EXPECT_LE(max_error, MAX_ERROR);
+}
+
+TEST(PlanarAngle, Axes)
+{
+    const double points[][2] = { {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1} };
+    for(unsigned int i=0; i<sizeof(points)/sizeof(points[0]); i++)
+    {
+        const double x = points[i][0], y = points[i][1];
+        EXPECT_NEAR(std::atan2(y, x), fast_atan2(y, x), MAX_ERROR) << "(" << x << ", " << y << ")";
+
+        // against the x axis, and against the heading of the point itself
+        EXPECT_NEAR(std::atan2(y, x), planar_angle(1.0, 0.0, x, y), MAX_ERROR) << "(" << x << ", " << y << ")";
+        EXPECT_NEAR(0.0, planar_angle(x, y, 2*x, 2*y), MAX_ERROR) << "(" << x << ", " << y << ")";
+        EXPECT_NEAR(0.0, planar_bearing(std::atan2(y, x), x, y), MAX_ERROR) << "(" << x << ", " << y << ")";
+    }
+    EXPECT_EQ(0.0, fast_atan2(0.0, 1.0));
+    EXPECT_NEAR(M_PI/2, fast_atan2(1.0, 0.0), MAX_ERROR);
+    EXPECT_NEAR(-M_PI/2, fast_atan2(-1.0, 0.0), MAX_ERROR);
+}
+
+TEST(PlanarAngle, Origin)
+{
+    // a target on the robot, or a zero heading vector, has no direction; 0 like std::atan2(0, 0)
+    EXPECT_EQ(0.0, fast_atan2(0.0, 0.0));
+    EXPECT_EQ(0.0, fast_atan2(-0.0, -0.0));
+    EXPECT_EQ(0.0, planar_angle(1.0, 0.0, 0.0, 0.0));
+    EXPECT_EQ(0.0, planar_angle(0.0, 0.0, 1.0, 1.0));
+    EXPECT_EQ(0.0, planar_bearing(0.7, 0.0, 0.0));
+
+    const double dx = 0.0, dy = 0.0;
+    double bearing = 1.0, range = 1.0;
+    planar_bearings(0.7, &dx, &dy, 1, &bearing, &range);
+    EXPECT_EQ(0.0, bearing);
+    EXPECT_EQ(0.0, range);
+}
+
+TEST(PlanarAngle, Seam)
+{
+    // fast_atan2() ignores the sign of a zero y: (-1, -0) is PI, where std::atan2 gives -PI
+    EXPECT_NEAR(M_PI, fast_atan2(0.0, -1.0), MAX_ERROR);
+    EXPECT_NEAR(M_PI, fast_atan2(-0.0, -1.0), MAX_ERROR);
+    EXPECT_EQ(-M_PI, std::atan2(-0.0, -1.0));
+    EXPECT_LE(angle_distance(fast_atan2(-0.0, -1.0), std::atan2(-0.0, -1.0)), MAX_ERROR);
+
+    // opposite vectors: get_angle_PI() gives -PI, planar_angle() PI; the same angle on the circle
+    EXPECT_NEAR(-M_PI, reference::get_angle_PI(1.0, 0.0, -1.0, 0.0), MAX_ERROR);
+    EXPECT_NEAR(M_PI, planar_angle(1.0, 0.0, -1.0, 0.0), MAX_ERROR);
+
+    // just off the seam both sides keep their sign
+    EXPECT_NEAR(std::atan2(1e-9, -1.0), fast_atan2(1e-9, -1.0), MAX_ERROR);
+    EXPECT_NEAR(std::atan2(-1e-9, -1.0), fast_atan2(-1e-9, -1.0), MAX_ERROR);
+    EXPECT_LT(fast_atan2(-1e-9, -1.0), 0.0);
+}
+
+TEST(PlanarAngle, PlanarAngleMatchesGetAnglePI)
+{
+    std::mt19937_64 rng(2);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    double max_error = 0.0;
+    for(unsigned int i=0; i<SAMPLES; i++)
+    {
+        const double ref_x = coordinate(rng), ref_y = coordinate(rng);
+        const double x = coordinate(rng), y = coordinate(rng);
+        max_error = std::max(max_error, angle_distance(planar_angle(ref_x, ref_y, x, y),
+                                                       reference::get_angle_PI(ref_x, ref_y, x, y)));
+    }
+    EXPECT_LE(max_error, MAX_ERROR);
+}
+
+TEST(PlanarAngle, PlanarBearingMatchesAtan2)
+{
+    std::mt19937_64 rng(3);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+    double max_error = 0.0;
+    for(unsigned int i=0; i<SAMPLES; i++)
+    {
+        const double yaw = heading(rng);
+        const double dx = coordinate(rng), dy = coordinate(rng);
+        max_error = std::max(max_error, angle_distance(planar_bearing(yaw, dx, dy), std::atan2(dy, dx) - yaw));
+    }
+    EXPECT_LE(max_error, MAX_ERROR);
+}
+
+TEST(PlanarAngle, BatchMatchesPerTarget)
+{
+    // an odd count, so the remainder loop after the SIMD lanes runs too
+    const unsigned int n = 37;
+    std::mt19937_64 rng(4);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    std::vector<double> dx(n), dy(n), bearing(n), range(n);
+    for(unsigned int i=0; i<n; i++)
+    {
+        dx[i] = coordinate(rng);
+        dy[i] = coordinate(rng);
+    }
+    dx[5] = dy[5] = 0.0;                                    // the robot itself
+    dx[6] = -1.0; dy[6] = 0.0;                              // behind, on the seam
+
+    const double yaw = 0.0;
+    planar_bearings(yaw, &dx[0], &dy[0], n, &bearing[0], &range[0]);
+    for(unsigned int i=0; i<n; i++)
+    {
+        EXPECT_NEAR(planar_bearing(yaw, dx[i], dy[i]), bearing[i], 1e-12) << "target " << i;
+        EXPECT_NEAR(std::sqrt(dx[i]*dx[i] + dy[i]*dy[i]), range[i], 1e-12) << "target " << i;
+        if(range[i] > 0.0)                                  // get_angle_PI() gives -PI/2 for a zero vector
+        {
+            EXPECT_LE(angle_distance(reference::get_angle_PI(1.0, 0.0, dx[i], dy[i]), bearing[i]), MAX_ERROR)
+                << "target " << i;
+        }
+    }
+}
+
+TEST(PlanarAngle, OwnHeadings)
+{
+    const unsigned int n = 37;
+    std::mt19937_64 rng(5);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+    std::vector<double> yaw(n), dx(n), dy(n), bearing(n), range(n);
+    for(unsigned int i=0; i<n; i++)
+    {
+        yaw[i] = heading(rng);
+        dx[i] = coordinate(rng);
+        dy[i] = coordinate(rng);
+    }
+    dx[5] = dy[5] = 0.0;                                    // the football itself
+    yaw[6] = M_PI;   dx[6] = -1.0; dy[6] = 0.0;             // straight ahead, headings on the seam
+    yaw[7] = -M_PI;  dx[7] = -1.0; dy[7] = -1e-9;
+    yaw[8] = M_PI;   dx[8] = 1.0;  dy[8] = 0.0;             // straight behind
+    yaw[9] = -M_PI;  dx[9] = 1.0;  dy[9] = 0.0;
+    yaw[10] = 2*M_PI; yaw[11] = -2*M_PI;                    // the widest headings allowed
+
+    planar_bearings_each(&yaw[0], &dx[0], &dy[0], n, &bearing[0], &range[0]);
+    for(unsigned int i=0; i<n; i++)
+    {
+        if(range[i] > 0.0)                                  // the football itself is checked below
+        {
+            EXPECT_LE(angle_distance(std::atan2(dy[i], dx[i]) - yaw[i], bearing[i]), MAX_ERROR) << "target " << i;
+        }
+        EXPECT_GT(bearing[i], -M_PI) << "target " << i;
+        EXPECT_LE(bearing[i], M_PI) << "target " << i;
+        EXPECT_NEAR(std::sqrt(dx[i]*dx[i] + dy[i]*dy[i]), range[i], 1e-12) << "target " << i;
+    }
+    EXPECT_EQ(0.0, bearing[5]);
+    EXPECT_NEAR(0.0, bearing[6], MAX_ERROR);
+    EXPECT_NEAR(M_PI, std::fabs(bearing[8]), MAX_ERROR);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,149 @@
+/* Desc: time of the bearings of many targets, the per-step passes of every robot and of the
+ *       world. Against one heading (transform_to_ego(), the goals): planar_bearings() in one
+ *       batch, planar_angle() with the cosine and sine of the heading computed once,
+ *       planar_bearing(), the rotation and std::atan2 it replaced, and the get_angle_PI() chain.
+ *       Each target against its own heading (transform_ball_to_egos()): planar_bearings_each(),
+ *       planar_bearing(), and the cosine, sine and std::atan2 per target it replaced.
+ * Usage: rosrun nubot_gazebo planar_angle_benchmark [repetitions]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "planar_angle.hh"
+#include "vector_angle_reference.hh"
+
+using namespace gazebo;
+
+typedef std::chrono::steady_clock clock_type;
+
+/// \brief Targets of one pass, and where their bearings and ranges go
+struct targets
+{
+    double                  yaw;                        // heading of the passes against one heading
+    std::vector<double>     heading;                    // headings of the passes against their own
+    std::vector<double>     dx, dy, bearing, range;
+};
+
+static void batch(targets & t)
+{
+    planar_bearings(t.yaw, &t.dx[0], &t.dy[0], t.dx.size(), &t.bearing[0], &t.range[0]);
+}
+
+static void precomputed(targets & t)
+{
+    const double c = std::cos(t.yaw), s = std::sin(t.yaw);
+    for(unsigned int i=0; i<t.dx.size(); i++)
+    {
+        t.range[i]   = std::sqrt(t.dx[i]*t.dx[i] + t.dy[i]*t.dy[i]);
+        t.bearing[i] = planar_angle(c, s, t.dx[i], t.dy[i]);
+    }
+}
+
+static void per_target(targets & t)
+{
+    for(unsigned int i=0; i<t.dx.size(); i++)
+    {
+        t.range[i]   = std::sqrt(t.dx[i]*t.dx[i] + t.dy[i]*t.dy[i]);
+        t.bearing[i] = planar_bearing(t.yaw, t.dx[i], t.dy[i]);
+    }
+}
+
+static void libm_atan2(targets & t)
+{
+    const double c = std::cos(t.yaw), s = std::sin(t.yaw);
+    for(unsigned int i=0; i<t.dx.size(); i++)
+    {
+        t.range[i]   = std::sqrt(t.dx[i]*t.dx[i] + t.dy[i]*t.dy[i]);
+        t.bearing[i] = std::atan2(-s*t.dx[i] + c*t.dy[i], c*t.dx[i] + s*t.dy[i]);
+    }
+}
+
+static void vector_angle(targets & t)
+{
+    const double c = std::cos(t.yaw), s = std::sin(t.yaw);
+    for(unsigned int i=0; i<t.dx.size(); i++)
+    {
+        t.range[i]   = std::sqrt(t.dx[i]*t.dx[i] + t.dy[i]*t.dy[i]);
+        t.bearing[i] = reference::get_angle_PI(c, s, t.dx[i], t.dy[i]);
+    }
+}
+
+static void batch_each(targets & t)
+{
+    planar_bearings_each(&t.heading[0], &t.dx[0], &t.dy[0], t.dx.size(), &t.bearing[0], &t.range[0]);
+}
+
+static void per_target_each(targets & t)
+{
+    for(unsigned int i=0; i<t.dx.size(); i++)
+    {
+        t.range[i]   = std::sqrt(t.dx[i]*t.dx[i] + t.dy[i]*t.dy[i]);
+        t.bearing[i] = planar_bearing(t.heading[i], t.dx[i], t.dy[i]);
+    }
+}
+
+static void libm_atan2_each(targets & t)
+{
+    for(unsigned int i=0; i<t.dx.size(); i++)
+    {
+        const double c = std::cos(t.heading[i]), s = std::sin(t.heading[i]);
+        t.range[i]   = std::sqrt(t.dx[i]*t.dx[i] + t.dy[i]*t.dy[i]);
+        t.bearing[i] = std::atan2(-s*t.dx[i] + c*t.dy[i], c*t.dx[i] + s*t.dy[i]);
+    }
+}
+
+/// \return ns per target
+static double time_pass(void (*pass)(targets &), targets & t, unsigned int repetitions, double & sink)
+{
+    pass(t);                                                // warm up the caches
+    clock_type::time_point start = clock_type::now();
+    for(unsigned int k=0; k<repetitions; k++)
+    {
+        t.yaw = 0.001 * k;
+        pass(t);
+        sink += t.bearing[k % t.dx.size()];
+    }
+    const double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+    return seconds * 1e9 / ((double)repetitions * t.dx.size());
+}
+
+int main(int argc, char **argv)
+{
+    const unsigned int repetitions = argc > 1 ? (unsigned int)std::atoi(argv[1]) : 200000;
+    const unsigned int counts[] = { 11, 64, 1024 };         // 5 vs 5 and the ball; bulk simulation
+    std::mt19937_64 rng(1);
+    std::uniform_real_distribution<double> coordinate(-10.0, 10.0);
+    std::uniform_real_distribution<double> heading(-M_PI, M_PI);
+    double sink = 0.0;
+
+    // every count runs the same number of targets as the repetitions of the first one
+    printf("ns per target; the first five columns against one heading, the last three each target against its own\n");
+    printf("%8s  %10s %10s %10s %10s %12s  %10s %10s %10s\n", "targets", "batch", "cos/sin", "planar_b.",
+           "std::atan2", "get_angle_PI", "batch", "planar_b.", "std::atan2");
+    for(unsigned int c=0; c<sizeof(counts)/sizeof(counts[0]); c++)
+    {
+        targets t;
+        const unsigned int n = counts[c];
+        t.yaw = 0.0;
+        t.heading.resize(n); t.dx.resize(n); t.dy.resize(n); t.bearing.resize(n); t.range.resize(n);
+        for(unsigned int i=0; i<n; i++)
+        {
+            t.heading[i] = heading(rng);
+            t.dx[i] = coordinate(rng);
+            t.dy[i] = coordinate(rng);
+        }
+        const unsigned int passes = std::max(1u, (unsigned int)((double)repetitions * counts[0] / n));
+        printf("%8u  %10.2f %10.2f %10.2f %10.2f %12.2f  %10.2f %10.2f %10.2f\n", n,
+               time_pass(&batch, t, passes, sink), time_pass(&precomputed, t, passes, sink),
+               time_pass(&per_target, t, passes, sink), time_pass(&libm_atan2, t, passes, sink),
+               time_pass(&vector_angle, t, passes, sink), time_pass(&batch_each, t, passes, sink),
+               time_pass(&per_target_each, t, passes, sink), time_pass(&libm_atan2_each, t, passes, sink));
+    }
+    return sink == 12345.0;                                 // keeps the passes from being optimized away
+}
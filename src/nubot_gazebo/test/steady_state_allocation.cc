@@ -0,0 +1,141 @@
+/* Desc: the steady-state step of a robot allocates no heap memory. Runs the Gazebo-free part
+ *       of what NubotGazebo runs for its robot every step, RobotBehaviour::update() and move(),
+ *       the fill of OmniVisionInfo and OdoInfo, and the fill of its team's WorldModelInfo by
+ *       TeamWorldPublisher, on a fixed world and counts the calls of operator new. The world
+ *       snapshot, the diagnostics reports and everything else that needs Gazebo are only checked
+ *       in gzserver, with libnubot_alloc_counter.so preloaded (see src/alloc_counter.hh).
+ * Usage: catkin_make run_tests_nubot_gazebo
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+#include "alloc_counter.hh"
+#include "robot_behaviour.hh"
+#include "robot_messages.hh"
+
+using namespace gazebo;
+
+static const int            ROBOTS = 10;               // five per team
+static const int            BALL = ROBOTS;             // the football follows the robots
+static const double         STEP_SIZE = 0.001;         // s, as in the Gazebo worlds
+static const unsigned int   WARM_UP_STEPS = 2000;      // more than the stuck window
+static const unsigned int   MEASURED_STEPS = 5000;
+
+/// \brief Engine that ignores all commands; the world stays fixed
+class NullBackend : public PhysicsBackend
+{
+  public:
+    virtual void set_robot_velocity(double vx, double vy, double w) {}
+    virtual double robot_height(void) const { return 0.0; }
+    virtual void set_ball_pose(double x, double y, double z, double yaw) {}
+    virtual void set_ball_velocity(double vx, double vy, double vz) {}
+};
+
+class SteadyStateStep : public ::testing::TestWithParam<bool>
+{
+  protected:
+    SteadyStateStep() : robot_(3), step_(0), stuck_(ROBOTS + 1, 0) {}
+
+    virtual void SetUp()
+    {
+        // also tells whether operator new of alloc_counter.cc is linked in at all
+        const unsigned long before = allocation_count();
+        world_.resize(ROBOTS + 1);
+        ASSERT_GT(allocation_count(), before) << "heap allocations are not counted";
+
+        for(int i=0; i<ROBOTS; i++)
+        {
+            const double side = i < ROBOTS/2 ? -1.0 : 1.0;
+            world_.x[i]   = side * (1.0 + i % (ROBOTS/2));
+            world_.y[i]   = 0.8 * (i % 3) - 0.8;
+            world_.yaw[i] = side < 0 ? 0.0 : M_PI;
+            world_.vx[i]  = 0.5 * side;
+            world_.vy[i]  = 0.2;
+            world_.w[i]   = 0.1;
+        }
+        world_.x[BALL] = 0.5;
+        world_.y[BALL] = -0.3;
+
+        const double stuck_window = 0.6;
+        behaviour_.configure(GetParam(), 1, robot_, stuck_window,
+                             (unsigned int)std::ceil(stuck_window / STEP_SIZE) + 2, 0.9);
+        behaviour_.set_params(0.10, 0.01);
+        behaviour_.set_goals(-9.0, 0.0, 9.0, 0.0);
+
+        // sized once, as NubotGazebo does when models are added or removed
+        for(int i=0; i<ROBOTS; i++)
+            if(i != robot_)
+                obstacles_.push_back(i);
+        omni_info_.obstacleinfo.pos.resize(obstacles_.size());
+        omni_info_.obstacleinfo.polar_pos.resize(obstacles_.size());
+        omni_info_.robotinfo.resize(1);
+
+        // and so does TeamWorldPublisher; the robot's team is the first half
+        team_.magenta = GetParam();
+        for(int i=0; i<ROBOTS; i++)
+        {
+            if((i < ROBOTS/2) == (robot_ < ROBOTS/2))
+            {
+                team_.teammates.push_back(i);
+                team_.agent_ids.push_back(i % (ROBOTS/2) + 1);
+            }
+            else
+                team_.opponents.push_back(i);
+        }
+        world_model_.robotinfo.resize(team_.teammates.size());
+        world_model_.oppinfo.pos.resize(team_.opponents.size());
+        world_model_.ballinfo.resize(1);
+    }
+
+    /// \brief One step of the robot
+    void step(void)
+    {
+        const double sim_time = step_ * STEP_SIZE;
+        behaviour_.update(world_, step_, sim_time, robot_, BALL, backend_);
+        behaviour_.move(1.0, 0.5, 0.3, backend_);
+
+        robot_message_state state;
+        state.agent_id  = robot_ + 1;
+        state.valid     = in_field(behaviour_.robot().x, behaviour_.robot().y);
+        state.hold_ball = false;
+        ros::Time stamp;
+        stamp.fromSec(sim_time);
+        fill_robot_messages(behaviour_, obstacles_, state, stamp, omni_info_, odo_info_);
+        fill_team_world_model(world_, team_, stuck_, BALL, robot_, stamp, world_model_);
+        step_++;
+    }
+
+    const int                       robot_;
+    uint64_t                        step_;
+    PlanarStates                    world_;
+    NullBackend                     backend_;
+    RobotBehaviour                  behaviour_;
+    std::vector<int>                obstacles_;
+    nubot_common::OminiVisionInfo   omni_info_;
+    nubot_common::OdoInfo           odo_info_;
+    std::vector<char>               stuck_;
+    team_world_layout               team_;
+    nubot_common::WorldModelInfo    world_model_;
+};
+
+TEST_P(SteadyStateStep, AllocatesNothing)
+{
+    for(unsigned int i=0; i<WARM_UP_STEPS; i++)
+        step();
+
+    const unsigned long before = allocation_count();
+    for(unsigned int i=0; i<MEASURED_STEPS; i++)
+        step();
+    EXPECT_EQ(0u, allocation_count() - before) << "heap allocations in " << MEASURED_STEPS << " steps";
+}
+
+// cyan robot, and a magenta one whose frame is flipped
+INSTANTIATE_TEST_CASE_P(Teams, SteadyStateStep, ::testing::Values(false, true));
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
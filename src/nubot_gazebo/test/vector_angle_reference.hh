@@ -0,0 +1,37 @@
+/* Desc: get_angle_PI() of src/vector_angle.hh for planar vectors, with the arithmetic of
+ *       gazebo::math::Vector3 (Normalize, Dot, Cross, GetLength) on plain doubles, so the
+ *       planar angle kernels are checked against it without Gazebo.
+ */
+
+#ifndef VECTOR_ANGLE_REFERENCE_HH
+#define VECTOR_ANGLE_REFERENCE_HH
+
+#include <cmath>
+
+namespace reference{
+   /// \brief math::Vector3::Normalize(): vectors shorter than math::equal()'s 1e-6 stay as they are
+   inline void normalize(double & x, double & y)
+   {
+       const double d = std::sqrt(x*x + y*y);
+       if(std::fabs(d) > 1e-6)
+       {
+           x /= d;
+           y /= d;
+       }
+   }
+
+   /// \brief get_angle_PI(math::Vector3(ref_x, ref_y, 0), math::Vector3(x, y, 0))
+   /// \return angle range [-PI, PI]; -PI for opposite vectors
+   inline double get_angle_PI(double ref_x, double ref_y, double x, double y)
+   {
+       normalize(ref_x, ref_y);
+       normalize(x, y);
+       const double cos_angle = ref_x*x + ref_y*y;
+       const double cross_z = ref_x*y - ref_y*x;
+       const double sin_angle = cross_z > 0 ? std::fabs(cross_z) : -std::fabs(cross_z);
+       const double angle = std::acos(cos_angle);
+       return sin_angle > 0 ? angle : -angle;
+   }
+}
+
+#endif //! VECTOR_ANGLE_REFERENCE_HH
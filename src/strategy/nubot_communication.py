@@ -1,8 +1,12 @@
 import rospy
 import math
+import threading
+import time
 from nubot_common.msg import OminiVisionInfo
 from nubot_common.msg import VelCmd
-from transfer.msg import PPoint
+from nubot_common.msg import VelCmdStamped
+from nubot_common.msg import ActuatorCmd
+from nubot_common.msg import ActuatorState
 from nubot_common.srv import BallHandle
 from nubot_common.srv import Shoot
 
@@ -11,58 +15,129 @@ class Nubot_communication(object):
         self.init_flag1 = 0
         self.init_flag2 = 0
         self.robot_number = robot_number
+        # ~stamped_velcmd: send VelCmdStamped so that gzserver traces the command latency
+        self.stamped = rospy.get_param('~stamped_velcmd', False)
+        # ~actuator: velocity, dribble and kick go out on one topic and the ball state comes back
+        # on another, instead of a service round trip per request; the services are the fallback
+        self.actuator = rospy.get_param('~actuator', True) and not self.stamped
+        # ~actuator_timeout: longest wait (s of wall time) for the answer to a kick, e.g. while gzserver is paused
+        self.actuator_timeout = rospy.get_param('~actuator_timeout', 1.0)
+        self.actuator_cmd = ActuatorCmd()
+        self.ball_is_holding = 0
+        self.shoot_is_done = 0
+        self.robot_stuck = False
+        self.state_seq = 0                          # seq of the last command the actuator state answers
+        self.state_changed = threading.Condition()
+        self.proxies = {}
+        self.cmd_seq = 0
         self.subscriber(robot_id)
         self.publisher(robot_id)
 
     def subscriber(self, robot_id):
         if robot_id == 1:
             rospy.Subscriber('nubot{}/omnivision/OmniVisionInfo'.format(self.robot_number), OminiVisionInfo, self.getOmniVision)
-            rospy.Subscriber('nubot{}/omnivision/OmniVisionInfo/GoalInfo'.format(self.robot_number), PPoint, self.getGoalInfo)
+            if self.actuator:
+                rospy.Subscriber('nubot{}/nubotcontrol/actuator_state'.format(self.robot_number), ActuatorState, self.getActuatorState)
         else:
             rospy.Subscriber('rival{}/omnivision/OmniVisionInfo'.format(self.robot_number), OminiVisionInfo, self.getOmniVision)
-            rospy.Subscriber('rival{}/omnivision/OmniVisionInfo/GoalInfo'.format(self.robot_number), PPoint, self.getGoalInfo)
+            if self.actuator:
+                rospy.Subscriber('rival{}/nubotcontrol/actuator_state'.format(self.robot_number), ActuatorState, self.getActuatorState)
 
     def publisher(self, robot_id):
+        if self.actuator:
+            topic, msg_type = ('nubotcontrol/actuator', ActuatorCmd)
+        elif self.stamped:
+            topic, msg_type = ('nubotcontrol/velcmd_stamped', VelCmdStamped)
+        else:
+            topic, msg_type = ('nubotcontrol/velcmd', VelCmd)
         if robot_id == 1:
-            self.nubot_cmd_pub = rospy.Publisher('nubot{}/nubotcontrol/velcmd'.format(self.robot_number), VelCmd, queue_size=100)
+            self.nubot_cmd_pub = rospy.Publisher('nubot{}/{}'.format(self.robot_number, topic), msg_type, queue_size=100)
         else:
-            self.rival_cmd_pub = rospy.Publisher('rival{}/nubotcontrol/velcmd'.format(self.robot_number), VelCmd, queue_size=100)
+            self.rival_cmd_pub = rospy.Publisher('rival{}/{}'.format(self.robot_number, topic), msg_type, queue_size=100)
 
-    def ballhandle_client(self, robot_id):
+    def service_proxy(self, robot_id, name, srv_type):
+        # one persistent connection per service instead of a new one on every call
+        key = (robot_id, name)
+        if key not in self.proxies:
+            service = '{}{}/{}'.format('nubot' if robot_id == 1 else 'rival', self.robot_number, name)
+            rospy.wait_for_service(service)
+            self.proxies[key] = rospy.ServiceProxy(service, srv_type, persistent=True)
+        return self.proxies[key]
+
+    def call_service(self, robot_id, name, srv_type, *args):
+        try:
+            return self.service_proxy(robot_id, name, srv_type)(*args)
+        except rospy.ServiceException:
+            del self.proxies[(robot_id, name)]      # e.g. gzserver restarted; reconnect on the next call
+            raise
+
+    def pubActuator(self, robot_id):
+        self.cmd_seq += 1
+        self.actuator_cmd.seq = self.cmd_seq
         if robot_id == 1:
-            rospy.wait_for_service('nubot{}/BallHandle'.format(self.robot_number))
-            ballhandle_srv = rospy.ServiceProxy('nubot{}/BallHandle'.format(self.robot_number), BallHandle)
-            ballhandle_response = ballhandle_srv(1)
-            return ballhandle_response.BallIsHolding
+            self.nubot_cmd_pub.publish(self.actuator_cmd)
         else:
-            rospy.wait_for_service('rival{}/BallHandle'.format(self.robot_number))
-            ballhandle_srv = rospy.ServiceProxy('rival{}/BallHandle'.format(self.robot_number), BallHandle)
-            ballhandle_response = ballhandle_srv(1)
-            return ballhandle_response.BallIsHolding
+            self.rival_cmd_pub.publish(self.actuator_cmd)
+        return self.cmd_seq
+
+    def waitActuatorState(self, seq):
+        # blocks until an actuator state answers the command seq or a later one
+        deadline = time.time() + self.actuator_timeout
+        with self.state_changed:
+            while self.state_seq < seq and not rospy.is_shutdown():
+                remaining = deadline - time.time()
+                if remaining <= 0:
+                    return False
+                self.state_changed.wait(remaining)
+        return self.state_seq >= seq
+
+    def ballhandle_client(self, robot_id):
+        if self.actuator:
+            # dribbling stays requested with every following command; the answer is that of the last step
+            if not self.actuator_cmd.dribble:
+                self.actuator_cmd.dribble = 1
+                self.pubActuator(robot_id)
+            return self.ball_is_holding
+        return self.call_service(robot_id, 'BallHandle', BallHandle, 1).BallIsHolding
 
     def shoot_client(self, robot_id):
-        if robot_id == 1:
-            rospy.wait_for_service('nubot{}/Shoot'.format(self.robot_number))
-            nubot_goal_keeper_shoot_srv = rospy.ServiceProxy('nubot{}/Shoot'.format(self.robot_number), Shoot)
-            nubot_goal_keeper_shoot_ground_response = nubot_goal_keeper_shoot_srv(5, 1)
-            return nubot_goal_keeper_shoot_ground_response.ShootIsDone
-        else:
-            rospy.wait_for_service('rival{}/Shoot'.format(self.robot_number))
-            nubot_goal_keeper_shoot_srv = rospy.ServiceProxy('rival{}/Shoot'.format(self.robot_number), Shoot)
-            nubot_goal_keeper_shoot_ground_response = nubot_goal_keeper_shoot_srv(5, 1)
-            return nubot_goal_keeper_shoot_ground_response.ShootIsDone
+        if self.actuator:
+            # the kick goes out once; its ShootIsDone comes with the first actuator state that has
+            # taken the command over, as the Shoot service answers after the kick is decided
+            self.actuator_cmd.shoot = True
+            self.actuator_cmd.strength = 5
+            self.actuator_cmd.ShootPos = 1
+            seq = self.pubActuator(robot_id)
+            self.actuator_cmd.shoot = False
+            if not self.waitActuatorState(seq):
+                rospy.logwarn('no actuator state for kick %d within %.1f s', seq, self.actuator_timeout)
+                return 0
+            return self.shoot_is_done
+        return self.call_service(robot_id, 'Shoot', Shoot, 5, 1).ShootIsDone
 
     def getOmniVision(self, vision):
         self.init_flag1 = 1
         self.ball_dis = vision.ballinfo.real_pos.radius
         self.ball_ang = math.degrees(vision.ballinfo.real_pos.angle)
+        self.getGoalInfo(vision.goalinfo)
     
+    def getActuatorState(self, state):
+        with self.state_changed:
+            self.ball_is_holding = int(state.BallIsHolding)
+            self.shoot_is_done = int(state.ShootIsDone)
+            self.robot_stuck = state.RobotStuck
+            self.state_seq = state.seq
+            self.state_changed.notify_all()
+
     def getGoalInfo(self, goal_info):
+        # goals come with the ball in OmniVisionInfo, in the robot's own frame; right_goal is the attacked one
+        if not goal_info.pos_known:
+            return
         self.init_flag2 = 1
-        self.left_goal_dis = goal_info.left_radius
-        self.left_goal_ang = goal_info.left_angle
-        self.right_goal_dis = goal_info.right_radius
-        self.right_goal_ang = goal_info.right_angle
+        self.left_goal_dis = goal_info.left_goal.radius
+        self.left_goal_ang = math.degrees(goal_info.left_goal.angle)
+        self.right_goal_dis = goal_info.right_goal.radius
+        self.right_goal_ang = math.degrees(goal_info.right_goal.angle)
 
     def pubNubotCtrl(self, x, y, yaw, robot_id):
         angle = yaw
@@ -109,9 +184,20 @@ class Nubot_communication(object):
         vel.Vy = y
         vel.w = yaw
         
-        if robot_id == 1:
-            self.nubot_cmd_pub.publish(vel)
+        if self.actuator:
+            self.actuator_cmd.vel = vel
+            self.pubActuator(robot_id)
         else:
-            self.rival_cmd_pub.publish(vel)
+            msg = vel
+            if self.stamped:
+                # wall clock, so that the latency is measured the same way under sim time
+                self.cmd_seq += 1
+                msg = VelCmdStamped(vel=vel)
+                msg.header.seq = self.cmd_seq
+                msg.header.stamp = rospy.Time.from_sec(time.time())
+            if robot_id == 1:
+                self.nubot_cmd_pub.publish(msg)
+            else:
+                self.rival_cmd_pub.publish(msg)
 
         print('\r vel.Vx: {}\n vel.Vy: {}\n vel.w: {}'.format(vel.Vx, vel.Vy, vel.w))
\ No newline at end of file